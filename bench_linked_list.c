@@ -0,0 +1,952 @@
+#include "linked_list.h"
+#include "unrolled_list.h"
+#include "compact_list.h"
+#include "doubly_list.h"
+#include "skip_list.h"
+#include "lockfree_list.h"
+#include "epoch.h"
+#include "list_parallel.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "common_defs.h"
+
+#define POOL_SIZE (16 * 1024 * 1024)
+#define ELEMENTS 20000
+#define ROUNDS 200
+
+// Threads bench_parallel scales up to; 0 for one per online CPU
+static int bench_threads = 0;
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double seconds)
+{
+    double values = (double)ELEMENTS * ROUNDS;
+    printf("    %-28s %8.2f Mvalues/s\n", name, values / seconds / 1e6);
+}
+
+// Full-length searches (for the last value) over each layout
+void bench_traversal()
+{
+    printf_yellow("  Traversal of %d values, %d rounds:\n", ELEMENTS, ROUNDS);
+    mem_init(POOL_SIZE);
+
+    List list = {NULL, NULL, 0, NULL};
+    UnrolledList unrolled;
+    ulist_init(&unrolled);
+    CompactList compact;
+    clist_init(&compact, ELEMENTS);
+    for (int i = 0; i < ELEMENTS; i++)
+    {
+        list_push_back(&list, i);
+        ulist_insert(&unrolled, i);
+        clist_push_back(&compact, i);
+    }
+    uint16_t last = ELEMENTS - 1;
+    volatile size_t sink = 0;
+
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        sink += list_search(&list.head, last) != NULL;
+    }
+    report("list_search", now_seconds() - start);
+
+    start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        size_t index;
+        sink += ulist_search(&unrolled, last, &index);
+    }
+    report("ulist_search", now_seconds() - start);
+
+    start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        sink += clist_find(&compact, last) != NODE_ARENA_NONE;
+    }
+    report("clist_find", now_seconds() - start);
+
+    list_destroy(&list);
+    ulist_cleanup(&unrolled);
+    clist_destroy(&compact);
+    mem_deinit();
+}
+
+// Searches and counts that scan a million-value unrolled list, per instruction set
+void bench_simd_search()
+{
+    enum { VALUES = 1000000, SCANS = 50 };
+    printf_yellow("  Scans of a %d value unrolled list, %d rounds:\n", VALUES, SCANS);
+    mem_init(POOL_SIZE);
+    UnrolledList unrolled;
+    ulist_init(&unrolled);
+    for (int i = 0; i < VALUES; i++)
+    {
+        ulist_insert(&unrolled, i % 60000);
+    }
+
+    struct
+    {
+        const char *name;
+        UlistSimd level;
+    } levels[] = {{"scalar", ULIST_SIMD_SCALAR}, {"SSE2", ULIST_SIMD_SSE2}, {"AVX2", ULIST_SIMD_AVX2}};
+    volatile size_t sink = 0;
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+    {
+        if (!ulist_set_simd(levels[l].level))
+        {
+            printf("    %-8s not supported by this CPU\n", levels[l].name);
+            continue;
+        }
+        double start = now_seconds();
+        for (int r = 0; r < SCANS; r++)
+        {
+            sink += ulist_search(&unrolled, 65000, NULL); // Absent: scans everything
+        }
+        double search = now_seconds() - start;
+        start = now_seconds();
+        for (int r = 0; r < SCANS; r++)
+        {
+            sink += ulist_count_value(&unrolled, 1234);
+        }
+        double count = now_seconds() - start;
+        printf("    %-8s search %8.2f Mvalues/s   count %8.2f Mvalues/s\n", levels[l].name,
+               (double)VALUES * SCANS / search / 1e6, (double)VALUES * SCANS / count / 1e6);
+    }
+    ulist_set_simd(ULIST_SIMD_AUTO);
+    ulist_cleanup(&unrolled);
+    mem_deinit();
+}
+
+// Lookups of random values, with and without the value index
+void bench_value_index()
+{
+    enum { LOOKUPS = 200000 };
+    printf_yellow("  %d lookups in a %d node list:\n", LOOKUPS, ELEMENTS);
+    mem_init(POOL_SIZE);
+    List list = {NULL, NULL, 0, NULL};
+    for (int i = 0; i < ELEMENTS; i++)
+    {
+        list_push_back(&list, i);
+    }
+
+    volatile size_t sink = 0;
+    for (int indexed = 0; indexed < 2; indexed++)
+    {
+        if (indexed)
+        {
+            list_index_enable(&list);
+        }
+        unsigned seed = 1;
+        double start = now_seconds();
+        for (int i = 0; i < LOOKUPS; i++)
+        {
+            sink += list_find(&list, rand_r(&seed) % ELEMENTS) != NULL;
+        }
+        double seconds = now_seconds() - start;
+        printf("    %-28s %8.2f Mlookups/s\n", indexed ? "list_find with index" : "list_find", LOOKUPS / seconds / 1e6);
+    }
+    list_destroy(&list);
+    mem_deinit();
+}
+
+// Dumps of a multi-million node list to /dev/null, per value with printf-style
+// calls and through the buffered writer
+void bench_dump()
+{
+    enum { NODES = 4000000 };
+    printf_yellow("  Dumps of a %d node list to /dev/null:\n", NODES);
+    List list;
+    list_create(&list, (size_t)NODES * sizeof(Node));
+    for (int i = 0; i < NODES; i++)
+    {
+        list_push_back(&list, (uint16_t)(i * 7919));
+    }
+
+    FILE *null_file = fopen("/dev/null", "w");
+    double start = now_seconds();
+    fprintf(null_file, "[");
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        fprintf(null_file, "%d", node->data);
+        if (node->next != NULL)
+        {
+            fprintf(null_file, ", ");
+        }
+    }
+    fprintf(null_file, "]");
+    fflush(null_file);
+    double seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mnodes/s\n", "fprintf per node", NODES / seconds / 1e6);
+    fclose(null_file);
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    start = now_seconds();
+    list_dump(&list.head, null_fd);
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mnodes/s\n", "list_dump", NODES / seconds / 1e6);
+    close(null_fd);
+
+    list_destroy(&list);
+    mem_deinit();
+}
+
+// Inserts before and deletes of nodes the caller holds, spread over the list,
+// on the singly and the doubly linked list
+void bench_insert_before()
+{
+    enum { OPS = 20000 };
+    printf_yellow("  %d insert-before/delete pairs at random nodes of a %d node list:\n", OPS, ELEMENTS);
+    mem_init(POOL_SIZE);
+    List list = {NULL, NULL, 0, NULL};
+    DList doubly;
+    dlist_init(&doubly);
+    static Node *nodes[ELEMENTS];
+    static DNode *dnodes[ELEMENTS];
+    for (int i = 0; i < ELEMENTS; i++)
+    {
+        list_push_back(&list, i);
+        nodes[i] = list.tail;
+        dlist_insert(&doubly, i);
+        dnodes[i] = doubly.tail;
+    }
+
+    unsigned seed = 1;
+    double start = now_seconds();
+    for (int i = 0; i < OPS; i++)
+    {
+        list_insert_before_node(&list, nodes[rand_r(&seed) % ELEMENTS], 60000);
+        list_remove(&list, 60000);
+    }
+    double seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mops/s\n", "singly linked", 2.0 * OPS / seconds / 1e6);
+
+    seed = 1;
+    start = now_seconds();
+    for (int i = 0; i < OPS; i++)
+    {
+        DNode *next = dnodes[rand_r(&seed) % ELEMENTS];
+        dlist_insert_before(&doubly, next, 60000);
+        dlist_delete_node(&doubly, next->prev);
+    }
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mops/s\n", "doubly linked", 2.0 * OPS / seconds / 1e6);
+
+    list_destroy(&list);
+    dlist_cleanup(&doubly);
+    mem_tcache_flush();
+    mem_deinit();
+}
+
+// Searches and range queries on an unsorted List and a sorted skip list
+void bench_skip_list()
+{
+    enum { LOOKUPS = 200000, RANGES = 20000, WIDTH = 100 };
+    printf_yellow("  %d lookups and %d range queries of width %d on %d random values:\n", LOOKUPS, RANGES, WIDTH,
+                  ELEMENTS);
+    mem_init(POOL_SIZE);
+    List list = {NULL, NULL, 0, NULL};
+    SkipList skip;
+    skip_init(&skip);
+    unsigned seed = 1;
+    double start = now_seconds();
+    for (int i = 0; i < ELEMENTS; i++)
+    {
+        skip_insert(&skip, rand_r(&seed) % UINT16_MAX);
+    }
+    double seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Kinserts/s\n", "skip_insert", ELEMENTS / seconds / 1e3);
+    seed = 1;
+    start = now_seconds();
+    for (int i = 0; i < ELEMENTS; i++)
+    {
+        list_push_back(&list, rand_r(&seed) % UINT16_MAX);
+    }
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Kinserts/s\n", "list_push_back", ELEMENTS / seconds / 1e3);
+
+    // Lookups are cut to a tenth for the linear scan
+    volatile size_t sink = 0;
+    seed = 2;
+    start = now_seconds();
+    for (int i = 0; i < LOOKUPS / 10; i++)
+    {
+        sink += list_find(&list, rand_r(&seed) % UINT16_MAX) != NULL;
+    }
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mlookups/s\n", "list_find", LOOKUPS / 10 / seconds / 1e6);
+    seed = 2;
+    start = now_seconds();
+    for (int i = 0; i < LOOKUPS; i++)
+    {
+        sink += skip_search(&skip, rand_r(&seed) % UINT16_MAX) != NULL;
+    }
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mlookups/s\n", "skip_search", LOOKUPS / seconds / 1e6);
+
+    seed = 3;
+    start = now_seconds();
+    for (int i = 0; i < RANGES / 10; i++)
+    {
+        uint16_t low = rand_r(&seed) % (UINT16_MAX - WIDTH);
+        for (Node *node = list.head; node != NULL; node = node->next)
+        {
+            sink += node->data >= low && node->data <= low + WIDTH;
+        }
+    }
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mranges/s\n", "full scan", RANGES / 10 / seconds / 1e6);
+    seed = 3;
+    start = now_seconds();
+    for (int i = 0; i < RANGES; i++)
+    {
+        uint16_t low = rand_r(&seed) % (UINT16_MAX - WIDTH);
+        SkipRange range = skip_range(&skip, low, low + WIDTH);
+        while (skip_range_next(&range) != NULL)
+        {
+            sink++;
+        }
+    }
+    seconds = now_seconds() - start;
+    printf("    %-28s %8.2f Mranges/s\n", "skip_range", RANGES / seconds / 1e6);
+
+    list_destroy(&list);
+    skip_cleanup(&skip);
+    mem_tcache_flush();
+    mem_deinit();
+}
+
+// Sorted Node list behind one mutex, the baseline for the lock-free list
+typedef struct LockedList
+{
+    pthread_mutex_t lock;
+    Node *head;
+} LockedList;
+
+static void locked_op(LockedList *list, int op, uint16_t data)
+{
+    pthread_mutex_lock(&list->lock);
+    Node **link = &list->head;
+    while (*link != NULL && (*link)->data < data)
+    {
+        link = &(*link)->next;
+    }
+    bool present = *link != NULL && (*link)->data == data;
+    if (op == 0 && !present)
+    {
+        Node *node = mem_alloc_inline(sizeof(Node));
+        node->data = data;
+        node->next = *link;
+        *link = node;
+    }
+    else if (op == 1 && present)
+    {
+        Node *node = *link;
+        *link = node->next;
+        mem_free_inline(node, sizeof(Node));
+    }
+    pthread_mutex_unlock(&list->lock);
+}
+
+enum { CONCURRENT_OPS = 200000, CONCURRENT_KEYS = 512 };
+
+typedef struct ConcurrentRun
+{
+    LockedList *locked;
+    LfList *lockfree;
+    unsigned seed;
+} ConcurrentRun;
+
+// 10% inserts, 10% deletes and 80% searches of random keys
+static void *concurrent_worker(void *arg)
+{
+    ConcurrentRun *run = arg;
+    for (int i = 0; i < CONCURRENT_OPS; i++)
+    {
+        unsigned r = rand_r(&run->seed);
+        uint16_t data = r % CONCURRENT_KEYS;
+        int op = (r >> 16) % 10;
+        op = op == 0 ? 0 : op == 1 ? 1 : 2;
+        if (run->locked != NULL)
+        {
+            locked_op(run->locked, op, data);
+        }
+        else if (op == 0)
+        {
+            lf_insert(run->lockfree, data);
+        }
+        else if (op == 1)
+        {
+            lf_delete(run->lockfree, data);
+        }
+        else
+        {
+            lf_contains(run->lockfree, data);
+        }
+    }
+    return NULL;
+}
+
+static double run_concurrent(int nthreads, LockedList *locked, LfList *lockfree)
+{
+    pthread_t threads[nthreads];
+    ConcurrentRun runs[nthreads];
+    double start = now_seconds();
+    for (int t = 0; t < nthreads; t++)
+    {
+        runs[t] = (ConcurrentRun){locked, lockfree, (unsigned)t + 1};
+        pthread_create(&threads[t], NULL, concurrent_worker, &runs[t]);
+    }
+    for (int t = 0; t < nthreads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    return now_seconds() - start;
+}
+
+// Throughput of a mutex-guarded list and the lock-free list as threads are added
+void bench_concurrent()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf_yellow("  %d ops per thread on %d keys (10%% insert, 10%% delete), %ld CPUs:\n", CONCURRENT_OPS,
+                  CONCURRENT_KEYS, cpus);
+    mem_init(POOL_SIZE);
+    for (int nthreads = 1; nthreads <= 8; nthreads *= 2)
+    {
+        LockedList locked = {PTHREAD_MUTEX_INITIALIZER, NULL};
+        LfList lockfree;
+        lf_init(&lockfree);
+        for (int k = 0; k < CONCURRENT_KEYS; k += 2)
+        {
+            locked_op(&locked, 0, k);
+            lf_insert(&lockfree, k);
+        }
+        double ops = (double)CONCURRENT_OPS * nthreads;
+        double mutex_seconds = run_concurrent(nthreads, &locked, NULL);
+        double lockfree_seconds = run_concurrent(nthreads, NULL, &lockfree);
+        printf("    %d threads: mutex %8.2f Mops/s, lock-free %8.2f Mops/s\n", nthreads, ops / mutex_seconds / 1e6,
+               ops / lockfree_seconds / 1e6);
+        list_cleanup(&locked.head);
+        lf_destroy(&lockfree);
+    }
+    mem_deinit();
+}
+
+static int compare_u16(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+// Fresh list of random values with its nodes in address order
+static void build_random_list(List *list, int nodes)
+{
+    list_create(list, (size_t)nodes * sizeof(Node));
+    unsigned seed = 42;
+    for (int i = 0; i < nodes; i++)
+    {
+        list_push_back(list, rand_r(&seed) & 0xffff);
+    }
+}
+
+// Sorting a list of a million random values: copied out to an array and
+// back, merge sorted in place, and radix sorted in place
+void bench_sort()
+{
+    enum { NODES = 1 << 20 };
+    printf_yellow("  Sorting a %d node list of random values:\n", NODES);
+    List list;
+
+    build_random_list(&list, NODES);
+    double start = now_seconds();
+    uint16_t *values = malloc(sizeof(uint16_t) * NODES);
+    size_t n = 0;
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        values[n++] = node->data;
+    }
+    qsort(values, n, sizeof(uint16_t), compare_u16);
+    n = 0;
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        node->data = values[n++];
+    }
+    free(values);
+    double seconds = now_seconds() - start;
+    printf("    %-28s %8.2f ms\n", "copy, qsort, copy back", seconds * 1e3);
+    list_destroy(&list);
+
+    void (*sorts[])(Node **) = {list_sort, list_sort_radix};
+    const char *names[] = {"list_sort", "list_sort_radix"};
+    for (int s = 0; s < 2; s++)
+    {
+        build_random_list(&list, NODES);
+        start = now_seconds();
+        sorts[s](&list.head);
+        seconds = now_seconds() - start;
+        printf("    %-28s %8.2f ms\n", names[s], seconds * 1e3);
+
+        // Sorting again walks the nodes in their new, scattered order
+        for (Node *node = list.head; node != NULL; node = node->next)
+        {
+            node->data = rand() & 0xffff;
+        }
+        start = now_seconds();
+        sorts[s](&list.head);
+        seconds = now_seconds() - start;
+        printf("    %-28s %8.2f ms\n", "  again, nodes scattered", seconds * 1e3);
+        list_destroy(&list);
+    }
+    mem_deinit();
+}
+
+// Cache-miss counter for the calling thread, -1 where the kernel or the
+// machine has none (e.g. most VMs)
+static int open_cache_miss_counter()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Build a list whose order has nothing to do with where its nodes sit, by
+// inserting each node after a random one
+static void build_scattered_list(List *list, int nodes)
+{
+    list_create(list, (size_t)nodes * sizeof(Node));
+    Node **order = malloc(sizeof(Node *) * nodes);
+    unsigned seed = 7;
+    list_push_back(list, 0);
+    order[0] = list->head;
+    for (int i = 1; i < nodes; i++)
+    {
+        Node *prev = order[rand_r(&seed) % i];
+        list_insert_after_node(list, prev, i);
+        order[i] = prev->next;
+    }
+    free(order);
+}
+
+// Walks the list, reporting time and, if available, cache misses per node
+static void report_traversal(const char *name, List *list, int counter)
+{
+    enum { WALKS = 10 };
+    volatile size_t sink = 0;
+    if (counter >= 0)
+    {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    double start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        for (Node *node = list->head; node != NULL; node = node->next)
+        {
+            sink += node->data;
+        }
+    }
+    double seconds = now_seconds() - start;
+    double nodes = (double)WALKS * list_length(list);
+    printf("    %-28s %8.2f ns/node", name, seconds / nodes * 1e9);
+    uint64_t misses;
+    if (counter >= 0 && ioctl(counter, PERF_EVENT_IOC_DISABLE, 0) == 0 &&
+        read(counter, &misses, sizeof(misses)) == sizeof(misses))
+    {
+        printf(" %8.3f cache misses/node", misses / nodes);
+    }
+    printf("\n");
+}
+
+// Traversal of a list scattered by inserts after random nodes, before and
+// after list_compact
+void bench_compact()
+{
+    enum { NODES = 1 << 20 };
+    printf_yellow("  Traversal of a %d node list scattered by random inserts:\n", NODES);
+    mem_init((size_t)NODES * sizeof(Node) * 3);  // Room for the list's arena and the compacted copy
+    List list;
+    build_scattered_list(&list, NODES);
+
+    int counter = open_cache_miss_counter();
+    if (counter < 0)
+    {
+        printf("    (no cache-miss counter on this machine; timing only)\n");
+    }
+    report_traversal("scattered", &list, counter);
+    double start = now_seconds();
+    list_compact(&list);
+    printf("    %-28s %8.2f ms\n", "list_compact", (now_seconds() - start) * 1e3);
+    report_traversal("compacted", &list, counter);
+    if (counter >= 0)
+    {
+        close(counter);
+    }
+    list_destroy(&list);
+    mem_deinit();
+}
+
+// Stands in for per-node work a caller does while walking a list
+static inline uint32_t mix_value(uint32_t x)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        x = (x ^ (x >> 15)) * 0x2c1b3c6dU;
+    }
+    return x;
+}
+
+static bool sum_visit(Node *node, void *ctx)
+{
+    *(uint32_t *)ctx += node->data;
+    return true;
+}
+
+static bool mix_visit(Node *node, void *ctx)
+{
+    *(uint32_t *)ctx += mix_value(node->data);
+    return true;
+}
+
+static void report_walk(const char *name, double seconds, size_t nodes)
+{
+    printf("    %-28s %8.2f ns/node\n", name, seconds / nodes * 1e9);
+}
+
+// Walks of scattered Node and skip lists with plain loops and with the
+// prefetching list_foreach, skip_foreach and cursors
+void bench_prefetch()
+{
+    enum { NODES = 1 << 19, SKIP_NODES = 1 << 16, WALKS = 5 };
+    printf_yellow("  Walks of a scattered %d node list and a %d node skip list, %d rounds:\n", NODES, SKIP_NODES,
+                  WALKS);
+    List list;
+    build_scattered_list(&list, NODES);
+    size_t nodes = (size_t)NODES * WALKS;
+    volatile uint32_t sink = 0;
+
+    uint32_t sum = 0;
+    double start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        for (Node *node = list.head; node != NULL; node = node->next)
+        {
+            sum += node->data;
+        }
+    }
+    report_walk("loop, sum", now_seconds() - start, nodes);
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        list_foreach(&list.head, sum_visit, &sum);
+    }
+    report_walk("list_foreach, sum", now_seconds() - start, nodes);
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        for (Node *node = list.head; node != NULL; node = node->next)
+        {
+            sum += mix_value(node->data);
+        }
+    }
+    report_walk("loop, hash", now_seconds() - start, nodes);
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        list_foreach(&list.head, mix_visit, &sum);
+    }
+    report_walk("list_foreach, hash", now_seconds() - start, nodes);
+    list_destroy(&list);
+    mem_deinit();
+
+    // Skip list nodes come from the pool in insertion order, so walking
+    // them in value order jumps around the same way. It is kept smaller as
+    // the pool's first-fit allocation slows down with many blocks.
+    nodes = (size_t)SKIP_NODES * WALKS;
+    mem_init((size_t)SKIP_NODES * 64);
+    SkipList skip;
+    skip_init(&skip);
+    unsigned seed = 3;
+    for (int i = 0; i < SKIP_NODES; i++)
+    {
+        skip_insert(&skip, rand_r(&seed) % UINT16_MAX);
+    }
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        for (Node *node = skip.head->node.next; node != NULL; node = node->next)
+        {
+            sum += node->data;
+        }
+    }
+    report_walk("skip list loop, sum", now_seconds() - start, nodes);
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        skip_foreach(&skip, sum_visit, &sum);
+    }
+    report_walk("skip_foreach, sum", now_seconds() - start, nodes);
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        for (Node *node = skip.head->node.next; node != NULL; node = node->next)
+        {
+            sum += mix_value(node->data);
+        }
+    }
+    report_walk("skip list loop, hash", now_seconds() - start, nodes);
+    start = now_seconds();
+    for (int w = 0; w < WALKS; w++)
+    {
+        SkipCursor cursor;
+        skip_cursor_init(&cursor, &skip);
+        for (Node *node; (node = skip_cursor_next(&cursor)) != NULL;)
+        {
+            sum += mix_value(node->data);
+        }
+    }
+    report_walk("skip_cursor_next, hash", now_seconds() - start, nodes);
+    sink = sum;
+    (void)sink;
+    // Freeing node by node in value order is slow on a pool this full;
+    // dropping the pool frees the nodes just the same
+    mem_deinit();
+}
+
+// Sum and histogram of a long list on 1 to 8 threads, against a plain loop
+void bench_parallel()
+{
+    enum { NODES = 1 << 24, ROUNDS_PER_RUN = 3 };
+    printf_yellow("  Aggregates over %d nodes, %ld online CPUs:\n", NODES, sysconf(_SC_NPROCESSORS_ONLN));
+    List list;
+    list_create(&list, (size_t)NODES * sizeof(Node));
+    unsigned seed = 5;
+    for (int i = 0; i < NODES; i++)
+    {
+        list_push_back(&list, rand_r(&seed) % UINT16_MAX);
+    }
+    list_segments_enable(&list);
+    volatile uint64_t sink = 0;
+
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS_PER_RUN; r++)
+    {
+        uint64_t sum = 0;
+        for (Node *node = list.head; node != NULL; node = node->next)
+        {
+            sum += node->data;
+        }
+        sink += sum;
+    }
+    double base = (now_seconds() - start) / ROUNDS_PER_RUN;
+    printf("    %-28s %8.2f ms\n", "loop, sum", base * 1e3);
+
+    // Every thread count from 1 to the number of CPUs (or the count given
+    // on the command line), then twice that to show oversubscription
+    int max_threads = bench_threads > 0 ? bench_threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    max_threads = max_threads < 1 ? 1 : max_threads > THREAD_POOL_MAX / 2 ? THREAD_POOL_MAX / 2 : max_threads;
+    printf("    %-8s %12s %8s %14s %8s\n", "threads", "sum ms", "speedup", "histogram ms", "speedup");
+    uint64_t counts[256];
+    double sum_one = 0, histogram_one = 0;
+    for (int threads = 1; threads <= 2 * max_threads; threads = threads < max_threads ? threads + 1 : 2 * threads)
+    {
+        ThreadPool *pool = thread_pool_create(threads);
+        if (pool == NULL)
+        {
+            printf("    %-8d could not create the thread pool\n", threads);
+            continue;
+        }
+        start = now_seconds();
+        for (int r = 0; r < ROUNDS_PER_RUN; r++)
+        {
+            sink += list_parallel_sum(&list, pool);
+        }
+        double sum_seconds = (now_seconds() - start) / ROUNDS_PER_RUN;
+        start = now_seconds();
+        for (int r = 0; r < ROUNDS_PER_RUN; r++)
+        {
+            list_parallel_histogram(&list, pool, counts, 256);
+        }
+        double histogram_seconds = (now_seconds() - start) / ROUNDS_PER_RUN;
+        if (sum_one == 0)  // Speedups are relative to the first pool that started
+        {
+            sum_one = sum_seconds;
+            histogram_one = histogram_seconds;
+        }
+        printf("    %-8d %12.2f %7.2fx %14.2f %7.2fx\n", thread_pool_size(pool), sum_seconds * 1e3,
+               sum_one / sum_seconds, histogram_seconds * 1e3, histogram_one / histogram_seconds);
+        thread_pool_destroy(pool);
+    }
+    list_destroy(&list);
+    mem_deinit();
+}
+
+// Loading a list from an array and exporting it back, one node at a time
+// and with the bulk functions
+void bench_bulk()
+{
+    enum { NODES = 1 << 20, ROUNDS_PER_RUN = 10 };
+    printf_yellow("  Loading and exporting %d values, %d rounds:\n", NODES, ROUNDS_PER_RUN);
+    uint16_t *values = malloc(sizeof(uint16_t) * NODES);
+    uint16_t *exported = malloc(sizeof(uint16_t) * NODES);
+    unsigned seed = 9;
+    for (int i = 0; i < NODES; i++)
+    {
+        values[i] = rand_r(&seed) % UINT16_MAX;
+    }
+    List list;
+    double seconds = 0;
+    for (int r = 0; r < ROUNDS_PER_RUN; r++)
+    {
+        double start = now_seconds();
+        list_create(&list, (size_t)NODES * sizeof(Node));
+        for (int i = 0; i < NODES; i++)
+        {
+            list_push_back(&list, values[i]);
+        }
+        seconds += now_seconds() - start;
+        list_destroy(&list);
+        mem_deinit();
+    }
+    report_walk("list_push_back loop", seconds, (size_t)NODES * ROUNDS_PER_RUN);
+    seconds = 0;
+    for (int r = 0; r < ROUNDS_PER_RUN; r++)
+    {
+        double start = now_seconds();
+        list_from_array(&list, values, NODES);
+        seconds += now_seconds() - start;
+        if (r < ROUNDS_PER_RUN - 1)
+        {
+            list_destroy(&list);
+            mem_deinit();
+        }
+    }
+    report_walk("list_from_array", seconds, (size_t)NODES * ROUNDS_PER_RUN);
+
+    volatile uint16_t sink = 0;
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS_PER_RUN; r++)
+    {
+        size_t count = 0;
+        for (Node *node = list.head; node != NULL; node = node->next)
+        {
+            exported[count++] = node->data;
+        }
+        sink += exported[r];
+    }
+    report_walk("export loop", now_seconds() - start, (size_t)NODES * ROUNDS_PER_RUN);
+    start = now_seconds();
+    for (int r = 0; r < ROUNDS_PER_RUN; r++)
+    {
+        sink += list_to_array(&list, exported, NODES);
+    }
+    report_walk("list_to_array", now_seconds() - start, (size_t)NODES * ROUNDS_PER_RUN);
+    list_destroy(&list);
+    mem_deinit();
+    free(values);
+    free(exported);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s <benchmark> [threads for bench_parallel]\n", argv[0]);
+        printf("Available benchmarks:\n");
+        printf(" 1. bench_traversal - Compare search on Node, unrolled and compact lists\n");
+        printf(" 2. bench_simd_search - Compare scalar, SSE2 and AVX2 scans of a million values\n");
+        printf(" 3. bench_value_index - Compare lookups with and without the value index\n");
+        printf(" 4. bench_dump - Compare per-node printf with list_dump\n");
+        printf(" 5. bench_insert_before - Compare insert-before and delete on singly and doubly linked lists\n");
+        printf(" 6. bench_skip_list - Compare lookups and range queries on unsorted and skip lists\n");
+        printf(" 7. bench_concurrent - Compare a mutex-guarded list with the lock-free list\n");
+        printf(" 8. bench_sort - Compare array qsort, list_sort and list_sort_radix on a million nodes\n");
+        printf(" 9. bench_compact - Compare traversal of a scattered list before and after list_compact\n");
+        printf("10. bench_prefetch - Compare plain loops with the prefetching list_foreach and skip_foreach\n");
+        printf("11. bench_parallel - Scale list_parallel_sum and list_parallel_histogram from 1 thread to one per CPU\n");
+        printf("12. bench_bulk - Compare per-node loading and export with list_from_array and list_to_array\n");
+        printf(" 0. Run all benchmarks\n");
+        return 1;
+    }
+
+    if (argc > 2)
+    {
+        bench_threads = atoi(argv[2]);
+    }
+    switch (atoi(argv[1]))
+    {
+    case 0:
+        bench_traversal();
+        bench_simd_search();
+        bench_value_index();
+        bench_dump();
+        bench_insert_before();
+        bench_skip_list();
+        bench_concurrent();
+        bench_sort();
+        bench_compact();
+        bench_prefetch();
+        bench_parallel();
+        bench_bulk();
+        break;
+    case 1:
+        bench_traversal();
+        break;
+    case 2:
+        bench_simd_search();
+        break;
+    case 3:
+        bench_value_index();
+        break;
+    case 4:
+        bench_dump();
+        break;
+    case 5:
+        bench_insert_before();
+        break;
+    case 6:
+        bench_skip_list();
+        break;
+    case 7:
+        bench_concurrent();
+        break;
+    case 8:
+        bench_sort();
+        break;
+    case 9:
+        bench_compact();
+        break;
+    case 10:
+        bench_prefetch();
+        break;
+    case 11:
+        bench_parallel();
+        break;
+    case 12:
+        bench_bulk();
+        break;
+    default:
+        printf("Invalid benchmark\n");
+        break;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "memory_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "common_defs.h"
+
+#define POOL_SIZE (64 * 1024 * 1024)
+#define OPS_PER_THREAD 200000
+#define LIVE_BLOCKS 32
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Keeps a small ring of live blocks, replacing the oldest on every operation
+void *churn_worker(void *arg)
+{
+    unsigned seed = (unsigned)(size_t)arg;
+    void *live[LIVE_BLOCKS] = {0};
+    for (int i = 0; i < OPS_PER_THREAD; i++)
+    {
+        int slot = i % LIVE_BLOCKS;
+        mem_free(live[slot]);
+        live[slot] = mem_alloc(16 + rand_r(&seed) % 240);
+        if (live[slot] == NULL)
+        {
+            printf_red("Allocation failed in worker\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < LIVE_BLOCKS; i++)
+    {
+        mem_free(live[i]);
+    }
+    return NULL;
+}
+
+double run_churn(int nthreads)
+{
+    pthread_t threads[nthreads];
+    double start = now_seconds();
+    for (int t = 0; t < nthreads; t++)
+    {
+        pthread_create(&threads[t], NULL, churn_worker, (void *)(size_t)(t + 1));
+    }
+    for (int t = 0; t < nthreads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    return now_seconds() - start;
+}
+
+void bench_arena_modes()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int nthreads = 4 * (int)(cpus > 0 ? cpus : 1);
+    size_t per_thread_arenas = nthreads < MEM_MAX_ARENAS ? (size_t)nthreads : MEM_MAX_ARENAS;
+
+    printf_yellow("  Arena modes, %d threads on %ld CPUs (4x oversubscribed):\n", nthreads, cpus);
+
+    struct
+    {
+        const char *name;
+        MemArenaMode mode;
+        size_t arenas;
+    } modes[] = {
+        {"single", MEM_ARENA_SINGLE, 1},
+        {"per-thread", MEM_ARENA_PER_THREAD, per_thread_arenas},
+        {"per-CPU", MEM_ARENA_PER_CPU, (size_t)cpus},
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+    {
+        if (!mem_init_arenas(POOL_SIZE, modes[m].mode, modes[m].arenas))
+        {
+            printf_red("Pool initialization failed\n");
+            exit(EXIT_FAILURE);
+        }
+        double seconds = run_churn(nthreads);
+        double ops = 2.0 * OPS_PER_THREAD * nthreads;
+        printf("    %-10s %3zu arenas of %8zu bytes: %8.2f Mops/s\n", modes[m].name, modes[m].arenas,
+               (size_t)POOL_SIZE / modes[m].arenas, ops / seconds / 1e6);
+        mem_deinit();
+    }
+}
+
+// Allocates and frees a ring of small fixed-size blocks on one thread
+void bench_inline_fast_path()
+{
+    enum { BLOCKS = 64, ROUNDS = 100000 };
+    void *live[BLOCKS];
+    printf_yellow("  Fixed-size %d byte blocks, %d rounds of %d:\n", 16, ROUNDS, BLOCKS);
+
+    mem_init(POOL_SIZE);
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            live[i] = mem_alloc(16);
+        }
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            mem_free(live[i]);
+        }
+    }
+    double library = now_seconds() - start;
+
+    start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            live[i] = mem_alloc_inline(16);
+        }
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            mem_free_inline(live[i], 16);
+        }
+    }
+    double inlined = now_seconds() - start;
+    mem_tcache_flush();
+    mem_deinit();
+
+    double ops = 2.0 * ROUNDS * BLOCKS;
+    printf("    mem_alloc/mem_free               %8.2f Mops/s\n", ops / library / 1e6);
+    printf("    mem_alloc_inline/mem_free_inline %8.2f Mops/s\n", ops / inlined / 1e6);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s <benchmark>\n", argv[0]);
+        printf("Available benchmarks:\n");
+        printf(" 1. bench_arena_modes - Compare single, per-thread and per-CPU arenas\n");
+        printf(" 2. bench_inline_fast_path - Compare library calls with the inlined thread cache\n");
+        printf(" 0. Run all benchmarks\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case 0:
+        bench_arena_modes();
+        bench_inline_fast_path();
+        break;
+    case 1:
+        bench_arena_modes();
+        break;
+    case 2:
+        bench_inline_fast_path();
+        break;
+    default:
+        printf("Invalid benchmark\n");
+        break;
+    }
+    return 0;
+}
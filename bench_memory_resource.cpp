@@ -0,0 +1,108 @@
+#include "memory_manager.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <list>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+#include "common_defs.h"
+
+#define POOL_SIZE (64 * 1024 * 1024)
+#define ELEMENTS 5000
+#define ROUNDS 5
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Fills and drains each container type ROUNDS times on one resource
+static double run_containers(std::pmr::memory_resource *resource, int which)
+{
+    double start = now_seconds();
+    size_t checksum = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        if (which == 0)
+        {
+            std::pmr::vector<int> numbers(resource);
+            for (int i = 0; i < ELEMENTS; i++)
+            {
+                numbers.push_back(i);
+            }
+            checksum += numbers.size();
+        }
+        else if (which == 1)
+        {
+            std::pmr::unordered_map<int, int> map(resource);
+            for (int i = 0; i < ELEMENTS; i++)
+            {
+                map[i * 7] = i;
+            }
+            for (int i = 0; i < ELEMENTS; i += 2)
+            {
+                map.erase(i * 7);
+            }
+            checksum += map.size();
+        }
+        else
+        {
+            std::pmr::list<int> values(resource);
+            for (int i = 0; i < ELEMENTS; i++)
+            {
+                values.push_back(i);
+            }
+            values.remove_if([](int v) { return v % 3 == 0; });
+            checksum += values.size();
+        }
+    }
+    if (checksum == 0)
+    {
+        printf_red("Containers stayed empty\n");
+        exit(EXIT_FAILURE);
+    }
+    return now_seconds() - start;
+}
+
+void bench_containers()
+{
+    const char *names[] = {"vector", "unordered_map", "list"};
+    printf_yellow("  Standard containers, %d elements x %d rounds:\n", ELEMENTS, ROUNDS);
+    mem_init(POOL_SIZE);
+    for (int which = 0; which < 3; which++)
+    {
+        double system = run_containers(std::pmr::new_delete_resource(), which);
+        double pool = run_containers(mm::pool_memory_resource(), which);
+        printf("    %-14s new/delete %8.2f ms   pool %8.2f ms\n", names[which], system * 1e3, pool * 1e3);
+    }
+    mem_deinit();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s <benchmark>\n", argv[0]);
+        printf("Available benchmarks:\n");
+        printf(" 1. bench_containers - Compare std containers on new/delete and on the pool\n");
+        printf(" 0. Run all benchmarks\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case 0:
+        bench_containers();
+        break;
+    case 1:
+        bench_containers();
+        break;
+    default:
+        printf("Invalid benchmark\n");
+        break;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include "memory_manager.h"
+#include "compact_list.h"
+#include "list_writer.h"
+
+// Create an empty list with room for capacity nodes. The memory pool must
+// already be set up.
+bool clist_init(CompactList* list, size_t capacity) {
+    list->arena = node_arena_create(sizeof(CompactNode), capacity);
+    list->head = NODE_ARENA_NONE;
+    list->tail = NODE_ARENA_NONE;
+    list->length = 0;
+    return list->arena != NULL;
+}
+
+// Take a node from the arena and fill it in; its index, or NODE_ARENA_NONE
+static uint32_t clist_new_node(CompactList* list, uint16_t data, uint32_t next) {
+    CompactNode* node = (CompactNode*)node_arena_alloc(list->arena);
+    if (node == NULL) {
+        printf("Compact list is full.\n");
+        return NODE_ARENA_NONE;
+    }
+    node->data = data;
+    node->reserved = 0;
+    node->next = next;
+    return node_arena_index(list->arena, node);
+}
+
+// Append a node in O(1)
+bool clist_push_back(CompactList* list, uint16_t data) {
+    uint32_t index = clist_new_node(list, data, NODE_ARENA_NONE);
+    if (index == NODE_ARENA_NONE) {
+        return false;
+    }
+    if (list->tail == NODE_ARENA_NONE) {
+        list->head = index;
+    } else {
+        clist_node(list, list->tail)->next = index;
+    }
+    list->tail = index;
+    list->length++;
+    return true;
+}
+
+// Prepend a node in O(1)
+bool clist_push_front(CompactList* list, uint16_t data) {
+    uint32_t index = clist_new_node(list, data, list->head);
+    if (index == NODE_ARENA_NONE) {
+        return false;
+    }
+    list->head = index;
+    if (list->tail == NODE_ARENA_NONE) {
+        list->tail = index;
+    }
+    list->length++;
+    return true;
+}
+
+// Insert a new node after the node with index prev
+bool clist_insert_after(CompactList* list, uint32_t prev, uint16_t data) {
+    if (prev == NODE_ARENA_NONE) {
+        printf("Previous node cannot be NULL.\n");
+        return false;
+    }
+    CompactNode* prev_node = clist_node(list, prev);
+    uint32_t index = clist_new_node(list, data, prev_node->next);
+    if (index == NODE_ARENA_NONE) {
+        return false;
+    }
+    prev_node->next = index;
+    if (list->tail == prev) {
+        list->tail = index;
+    }
+    list->length++;
+    return true;
+}
+
+// Delete the first node with the specified data
+bool clist_remove(CompactList* list, uint16_t data) {
+    uint32_t prev = NODE_ARENA_NONE;
+    for (uint32_t index = list->head; index != NODE_ARENA_NONE; prev = index, index = clist_node(list, index)->next) {
+        CompactNode* node = clist_node(list, index);
+        if (node->data != data) {
+            continue;
+        }
+        if (prev == NODE_ARENA_NONE) {
+            list->head = node->next;
+        } else {
+            clist_node(list, prev)->next = node->next;
+        }
+        if (list->tail == index) {
+            list->tail = prev;
+        }
+        list->length--;
+        node_arena_free(list->arena, node);
+        return true;
+    }
+    return false;
+}
+
+// Index of the first node with the specified data, NODE_ARENA_NONE if none
+uint32_t clist_find(const CompactList* list, uint16_t data) {
+    for (uint32_t index = list->head; index != NODE_ARENA_NONE; index = clist_node(list, index)->next) {
+        if (clist_node(list, index)->data == data) {
+            return index;
+        }
+    }
+    return NODE_ARENA_NONE;
+}
+
+// Number of nodes in O(1)
+size_t clist_count(const CompactList* list) {
+    return list->length;
+}
+
+// Display all nodes in the same format as list_display
+void clist_display(const CompactList* list) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_writer_write(writer, "[", 1);
+    for (uint32_t index = list->head; index != NODE_ARENA_NONE; index = clist_node(list, index)->next) {
+        if (index != list->head) {
+            list_writer_write(writer, ", ", 2);
+        }
+        list_writer_u16(writer, clist_node(list, index)->data);
+    }
+    list_writer_write(writer, "]", 1);
+    list_writer_flush(writer);
+}
+
+// Free the list's arena, and with it every node
+void clist_destroy(CompactList* list) {
+    node_arena_destroy(list->arena);
+    list->arena = NULL;
+    list->head = NODE_ARENA_NONE;
+    list->tail = NODE_ARENA_NONE;
+    list->length = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef COMPACT_LIST_H
+#define COMPACT_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "node_arena.h"
+
+// Node linked by 32-bit index into its list's arena: 8 bytes instead of 16
+typedef struct CompactNode {
+    uint16_t data;      // Data field (16-bit unsigned integer)
+    uint16_t reserved;  // Padding; holds part of the free link while unused
+    uint32_t next;      // Index of the next node, NODE_ARENA_NONE if last
+} CompactNode;
+
+// Singly linked list whose nodes live in one contiguous arena. It holds no
+// pointers between nodes, so it survives the pool moving (see mem_restore).
+typedef struct CompactList {
+    NodeArena* arena;   // Node storage, allocated from the pool
+    uint32_t head;      // Index of the first node, NODE_ARENA_NONE if empty
+    uint32_t tail;      // Index of the last node, NODE_ARENA_NONE if empty
+    size_t length;      // Number of nodes
+} CompactList;
+
+bool clist_init(CompactList* list, size_t capacity);
+bool clist_push_back(CompactList* list, uint16_t data);
+bool clist_push_front(CompactList* list, uint16_t data);
+bool clist_insert_after(CompactList* list, uint32_t prev, uint16_t data);
+bool clist_remove(CompactList* list, uint16_t data);
+uint32_t clist_find(const CompactList* list, uint16_t data);
+size_t clist_count(const CompactList* list);
+void clist_display(const CompactList* list);
+void clist_destroy(CompactList* list);
+
+// Node with an index, e.g. from clist_find or a node's next field
+static inline CompactNode* clist_node(const CompactList* list, uint32_t index) {
+    return (CompactNode*)node_arena_slot(list->arena, index);
+}
+
+#endif
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include "memory_manager.h"
+#include "doubly_list.h"
+#include "list_writer.h"
+
+// Create an empty list. The memory pool must already be set up.
+void dlist_init(DList* list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// Take a node from the pool and link it in between prev and next, either of
+// which may be NULL at an end of the list
+static bool dlist_link(DList* list, DNode* prev, DNode* next, uint16_t data) {
+    DNode* node = mem_alloc_inline(sizeof(DNode));
+    if (node == NULL) {
+        printf("Memory allocation for new node failed.\n");
+        return false;
+    }
+    node->data = data;
+    node->prev = prev;
+    node->next = next;
+    if (prev != NULL) {
+        prev->next = node;
+    } else {
+        list->head = node;
+    }
+    if (next != NULL) {
+        next->prev = node;
+    } else {
+        list->tail = node;
+    }
+    list->length++;
+    return true;
+}
+
+// Append a node in O(1)
+bool dlist_insert(DList* list, uint16_t data) {
+    return dlist_link(list, list->tail, NULL, data);
+}
+
+// Prepend a node in O(1)
+bool dlist_insert_front(DList* list, uint16_t data) {
+    return dlist_link(list, NULL, list->head, data);
+}
+
+// Insert a new node after a node of the list in O(1)
+bool dlist_insert_after(DList* list, DNode* prev_node, uint16_t data) {
+    if (prev_node == NULL) {
+        printf("Previous node cannot be NULL.\n");
+        return false;
+    }
+    return dlist_link(list, prev_node, prev_node->next, data);
+}
+
+// Insert a new node before a node of the list in O(1), without a scan for
+// its predecessor
+bool dlist_insert_before(DList* list, DNode* next_node, uint16_t data) {
+    if (next_node == NULL) {
+        printf("Next node cannot be NULL.\n");
+        return false;
+    }
+    return dlist_link(list, next_node->prev, next_node, data);
+}
+
+// Unlink a node of the list and free it in O(1)
+void dlist_delete_node(DList* list, DNode* node) {
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    } else {
+        list->tail = node->prev;
+    }
+    list->length--;
+    mem_free_inline(node, sizeof(DNode));
+}
+
+// Delete the first node with the specified data; false if there is none
+bool dlist_delete(DList* list, uint16_t data) {
+    DNode* node = dlist_search(list, data);
+    if (node == NULL) {
+        return false;
+    }
+    dlist_delete_node(list, node);
+    return true;
+}
+
+// First node with the specified data, or NULL
+DNode* dlist_search(const DList* list, uint16_t data) {
+    for (DNode* node = list->head; node != NULL; node = node->next) {
+        if (node->data == data) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+// Last node with the specified data, or NULL; scans from the tail
+DNode* dlist_search_last(const DList* list, uint16_t data) {
+    for (DNode* node = list->tail; node != NULL; node = node->prev) {
+        if (node->data == data) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+// Number of nodes in O(1)
+size_t dlist_count(const DList* list) {
+    return list->length;
+}
+
+// Display all nodes from first to last, or last to first
+static void dlist_write(const DList* list, bool reverse) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_writer_write(writer, "[", 1);
+    DNode* first = reverse ? list->tail : list->head;
+    for (DNode* node = first; node != NULL; node = reverse ? node->prev : node->next) {
+        if (node != first) {
+            list_writer_write(writer, ", ", 2);
+        }
+        list_writer_u16(writer, node->data);
+    }
+    list_writer_write(writer, "]", 1);
+    list_writer_flush(writer);
+}
+
+// Display all nodes in the same format as list_display
+void dlist_display(const DList* list) {
+    dlist_write(list, false);
+}
+
+// Display all nodes from the tail back to the head
+void dlist_display_reverse(const DList* list) {
+    dlist_write(list, true);
+}
+
+// Free all nodes
+void dlist_cleanup(DList* list) {
+    DNode* node = list->head;
+    while (node != NULL) {
+        DNode* next = node->next;
+        mem_free_inline(node, sizeof(DNode));
+        node = next;
+    }
+    dlist_init(list);
+}
@@ -0,0 +1,37 @@
+#ifndef DOUBLY_LIST_H
+#define DOUBLY_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Node of a doubly linked list: the back link makes inserting before and
+// deleting a node the caller already holds O(1)
+typedef struct DNode {
+    uint16_t data;          // Data field (16-bit unsigned integer)
+    struct DNode* next;     // Pointer to the next node, NULL if last
+    struct DNode* prev;     // Pointer to the previous node, NULL if first
+} DNode;
+
+// Doubly linked list with the same operations as the Node list
+typedef struct DList {
+    DNode* head;        // First node, NULL if the list is empty
+    DNode* tail;        // Last node, NULL if the list is empty
+    size_t length;      // Number of nodes
+} DList;
+
+void dlist_init(DList* list);
+bool dlist_insert(DList* list, uint16_t data);
+bool dlist_insert_front(DList* list, uint16_t data);
+bool dlist_insert_after(DList* list, DNode* prev_node, uint16_t data);
+bool dlist_insert_before(DList* list, DNode* next_node, uint16_t data);
+bool dlist_delete(DList* list, uint16_t data);
+void dlist_delete_node(DList* list, DNode* node);
+DNode* dlist_search(const DList* list, uint16_t data);
+DNode* dlist_search_last(const DList* list, uint16_t data);
+size_t dlist_count(const DList* list);
+void dlist_display(const DList* list);
+void dlist_display_reverse(const DList* list);
+void dlist_cleanup(DList* list);
+
+#endif
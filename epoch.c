@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "memory_manager.h"
+#include "epoch.h"
+
+// Per-thread announcement, one cache line each so readers do not contend.
+// state is 0 outside read-side sections, else (epoch << 1) | 1.
+typedef struct EpochRecord {
+    unsigned long state;
+    int used;
+} __attribute__((aligned(64))) EpochRecord;
+
+// Blocks retired in one epoch, waiting to be freed
+typedef struct EpochRetired {
+    void* ptr;
+    EpochFree free_fn;
+} EpochRetired;
+
+typedef struct EpochLimbo {
+    EpochRetired* items;
+    size_t count;
+    size_t capacity;
+    unsigned long epoch;    // Epoch the items were retired in
+} EpochLimbo;
+
+static EpochRecord epoch_records[EPOCH_MAX_THREADS];
+static unsigned long global_epoch = 0;
+
+// The calling thread's record, section nesting depth and retired blocks, one
+// list for each of the three epochs that can still be pending
+static __thread EpochRecord* epoch_record = NULL;
+static __thread int epoch_depth = 0;
+static __thread EpochLimbo epoch_limbo[3];
+static __thread size_t epoch_retired = 0;
+
+static pthread_key_t epoch_key;    // Drains a thread's blocks when it exits
+static pthread_once_t epoch_key_once = PTHREAD_ONCE_INIT;
+
+// Free a limbo list's blocks
+static void limbo_free(EpochLimbo* limbo) {
+    for (size_t i = 0; i < limbo->count; i++) {
+        limbo->items[i].free_fn(limbo->items[i].ptr);
+    }
+    epoch_retired -= limbo->count;
+    limbo->count = 0;
+}
+
+// Free every limbo list whose epoch is at least two behind the global one
+static void epoch_reclaim(void) {
+    unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < 3; i++) {
+        if (epoch_limbo[i].count > 0 && epoch_limbo[i].epoch + 2 <= epoch) {
+            limbo_free(&epoch_limbo[i]);
+        }
+    }
+}
+
+// Move the global epoch on if every reader has seen the current one
+static bool epoch_try_advance(void) {
+    unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < EPOCH_MAX_THREADS; i++) {
+        if (!__atomic_load_n(&epoch_records[i].used, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        unsigned long state = __atomic_load_n(&epoch_records[i].state, __ATOMIC_SEQ_CST);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return false;
+        }
+    }
+    return __atomic_compare_exchange_n(&global_epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST,
+                                       __ATOMIC_RELAXED);
+}
+
+// Free everything a thread retired and give up its record when it exits. A
+// thread that exits inside a read-side section leaves it first, or it would
+// wait for itself.
+static void epoch_thread_exit(void* record) {
+    epoch_depth = 0;
+    __atomic_store_n(&((EpochRecord*)record)->state, 0, __ATOMIC_RELEASE);
+    epoch_synchronize();
+    for (int i = 0; i < 3; i++) {
+        free(epoch_limbo[i].items);
+        epoch_limbo[i].items = NULL;
+        epoch_limbo[i].capacity = 0;
+    }
+    __atomic_store_n(&((EpochRecord*)record)->used, 0, __ATOMIC_RELEASE);
+    epoch_record = NULL;
+}
+
+static void epoch_key_create(void) {
+    pthread_key_create(&epoch_key, epoch_thread_exit);
+}
+
+// Claim a record for the calling thread
+static bool epoch_register(void) {
+    for (int i = 0; i < EPOCH_MAX_THREADS; i++) {
+        int unused = 0;
+        if (__atomic_compare_exchange_n(&epoch_records[i].used, &unused, 1, false, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED)) {
+            epoch_record = &epoch_records[i];
+            pthread_once(&epoch_key_once, epoch_key_create);
+            pthread_setspecific(epoch_key, epoch_record);
+            return true;
+        }
+    }
+    printf("Too many threads for epoch-based reclamation (max %d).\n", EPOCH_MAX_THREADS);
+    return false;
+}
+
+/**
+ * Start a read-side section. Blocks reachable from the shared structure when
+ * the section starts are not freed until it ends. Sections may nest.
+ *
+ * @return false if the thread could not get a record; the caller must not
+ *         enter the structure then.
+ */
+bool epoch_enter(void) {
+    if (epoch_record == NULL && !epoch_register()) {
+        return false;
+    }
+    if (epoch_depth++ == 0) {
+        unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&epoch_record->state, (epoch << 1) | 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    return true;
+}
+
+// End a read-side section. Does nothing outside one, e.g. after an
+// epoch_enter that failed.
+void epoch_exit(void) {
+    if (epoch_depth == 0) {
+        return;
+    }
+    if (--epoch_depth == 0) {
+        __atomic_store_n(&epoch_record->state, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * Free a block once no reader can still see it. The block must already be
+ * unreachable for readers that start from now on.
+ *
+ * @param ptr: Block to free.
+ * @param free_fn: Function that frees it, NULL for mem_free.
+ */
+void epoch_retire(void* ptr, EpochFree free_fn) {
+    unsigned long epoch = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE);
+    EpochLimbo* limbo = &epoch_limbo[epoch % 3];
+    if (limbo->epoch != epoch) {
+        // The list holds blocks from three or more epochs ago
+        limbo_free(limbo);
+        limbo->epoch = epoch;
+    }
+    if (limbo->count == limbo->capacity) {
+        size_t capacity = limbo->capacity ? limbo->capacity * 2 : EPOCH_BATCH;
+        EpochRetired* items = realloc(limbo->items, capacity * sizeof(EpochRetired));
+        if (items == NULL) {
+            // Nowhere to park the block: wait out the readers instead
+            epoch_synchronize();
+            (free_fn ? free_fn : mem_free)(ptr);
+            return;
+        }
+        limbo->items = items;
+        limbo->capacity = capacity;
+    }
+    limbo->items[limbo->count].ptr = ptr;
+    limbo->items[limbo->count].free_fn = free_fn ? free_fn : mem_free;
+    limbo->count++;
+    if (++epoch_retired % EPOCH_BATCH == 0) {
+        epoch_try_advance();
+        epoch_reclaim();
+    }
+}
+
+// Wait until every read-side section running at the call has ended, then free
+// the blocks the calling thread retired before it. Must not be called inside
+// a read-side section.
+void epoch_synchronize(void) {
+    unsigned long target = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE) + 2;
+    while (__atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE) < target) {
+        if (!epoch_try_advance()) {
+            sched_yield();
+        }
+    }
+    epoch_reclaim();
+}
+
+// Blocks the calling thread has retired and not yet freed
+size_t epoch_pending(void) {
+    return epoch_retired;
+}
@@ -0,0 +1,27 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Threads that can be inside read-side sections at the same time
+#define EPOCH_MAX_THREADS 64
+
+// Retired blocks a thread collects before it tries to move the epoch on
+#define EPOCH_BATCH 64
+
+// Frees a retired block
+typedef void (*EpochFree)(void* ptr);
+
+// Epoch-based reclamation. Readers bracket every traversal of a shared
+// structure with epoch_enter/epoch_exit; writers unlink a block and pass it
+// to epoch_retire instead of freeing it. A block retired in epoch e is freed
+// once the global epoch reaches e + 2, when no reader that could have seen
+// it is left. Retired blocks are kept per thread and freed by that thread.
+bool epoch_enter(void);
+void epoch_exit(void);
+void epoch_retire(void* ptr, EpochFree free_fn);
+void epoch_synchronize(void);
+size_t epoch_pending(void);
+
+#endif
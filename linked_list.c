@@ -4,10 +4,120 @@
 #include <stdlib.h>
 #include "memory_manager.h"
 #include "linked_list.h"
+#include "node_arena.h"
+#include "list_writer.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-// Initialize the linked list by allocating memory for 'size' number of nodes
+// Pool space kept beside the node arena for other allocations and for nodes
+// beyond the arena's capacity
+#define LIST_POOL_HEADROOM 50000
+
+// Node arenas live at once; lists made beyond that take their nodes from the pool
+#define LIST_MAX_ARENAS 16
+
+// Nodes preallocated by list_init, one arena per list. The arenas are found
+// again by their offsets when the pool is replaced, e.g. by mem_restore.
+static NodeArena* node_arenas[LIST_MAX_ARENAS];
+static size_t node_arena_offsets[LIST_MAX_ARENAS];
+static size_t node_arena_count = 0;
+static unsigned node_arena_generation = 0;
+
+// Number of arenas in the current pool; arenas it does not hold are dropped
+static size_t list_arenas(void) {
+    unsigned generation = __atomic_load_n(&mem_pool_generation, __ATOMIC_ACQUIRE);
+    if (node_arena_generation != generation) {
+        size_t kept = 0;
+        for (size_t i = 0; i < node_arena_count; i++) {
+            NodeArena* arena = (NodeArena*)mem_from_offset(node_arena_offsets[i]);
+            if (arena != NULL && arena->magic == NODE_ARENA_MAGIC && arena->slot_size == sizeof(Node)) {
+                node_arenas[kept] = arena;
+                node_arena_offsets[kept++] = node_arena_offsets[i];
+            }
+        }
+        node_arena_count = kept;
+        node_arena_generation = generation;
+    }
+    return node_arena_count;
+}
+
+// The arena of the most recently made list, or NULL if there is none
+static NodeArena* list_arena(void) {
+    size_t count = list_arenas();
+    return count > 0 ? node_arenas[count - 1] : NULL;
+}
+
+// Start using an arena for new nodes; false if the table of arenas is full
+static bool list_arena_add(NodeArena* arena) {
+    list_arenas();
+    if (node_arena_count == LIST_MAX_ARENAS) {
+        printf("Too many node arenas.\n");
+        return false;
+    }
+    node_arenas[node_arena_count] = arena;
+    node_arena_offsets[node_arena_count++] = mem_offset(arena);
+    return true;
+}
+
+// Give the arenas of lists that have been cleaned up back to the pool
+static void list_arenas_sweep(void) {
+    size_t count = list_arenas();
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (node_arenas[i]->used == 0) {
+            node_arena_destroy(node_arenas[i]);
+            continue;
+        }
+        node_arenas[kept] = node_arenas[i];
+        node_arena_offsets[kept++] = node_arena_offsets[i];
+    }
+    node_arena_count = kept;
+}
+
+// Take a node from the newest arena with room, or from the pool once all are full
+static Node* list_node_alloc(void) {
+    for (size_t i = list_arenas(); i-- > 0;) {
+        Node* node = (Node*)node_arena_alloc(node_arenas[i]);
+        if (node != NULL) {
+            return node;
+        }
+    }
+    return (Node*)mem_alloc_inline(sizeof(Node));
+}
+
+static void list_node_free(Node* node) {
+    for (size_t i = list_arenas(); i-- > 0;) {
+        if (node_arena_owns(node_arenas[i], node)) {
+            node_arena_free(node_arenas[i], node);
+            return;
+        }
+    }
+    mem_free_inline(node, sizeof(Node));
+}
+
+// Initialize the linked list with room for size / sizeof(Node) nodes, kept in
+// one contiguous array so nodes are allocated and freed in O(1) and sit next
+// to each other in memory. Every list shares one memory pool: it is created,
+// sized for the list, if there is none, and replaced by a larger one if it
+// is too small and holds nothing. Otherwise the list goes into the pool as it
+// is, and nodes that do not fit in it come from the rest of the pool.
 void list_init(Node** head, size_t size) {
-    mem_init(50000);  // Initiera minnespoolen med tillräcklig storlek (2KB här som exempel)
+    size_t capacity = size / sizeof(Node);
+    size_t bytes = node_arena_bytes(sizeof(Node), capacity) + LIST_POOL_HEADROOM;
+    list_arenas_sweep();
+    mem_tcache_flush();  // Cached nodes count as used
+    if (mem_size() != 0 && mem_used() == 0 && mem_size() < bytes) {
+        mem_deinit();
+    }
+    if (mem_size() == 0) {
+        mem_init(bytes);
+        node_arena_count = 0;
+    }
+    NodeArena* arena = capacity > 0 ? node_arena_create(sizeof(Node), capacity) : NULL;
+    if (arena != NULL && !list_arena_add(arena)) {
+        node_arena_destroy(arena);  // The list's nodes come from the pool
+    }
     *head = NULL;  // Initiera head som NULL
 }
 
@@ -19,7 +129,7 @@ void list_init(Node** head, size_t size) {
 void list_insert(Node** head, uint16_t data) {
     printf("Inserting new node with data: %d\n", data);
     
-    Node* new_node = (Node*)mem_alloc(sizeof(Node));
+    Node* new_node = list_node_alloc();
     if (new_node == NULL) {
         printf("Memory allocation for new node failed.\n");
         return;  // Stop further operations if memory allocation fails
@@ -56,7 +166,7 @@ void list_insert_after(Node* prev_node, uint16_t data) {
 
     printf("Inserting new node with data: %d after node with data: %d\n", data, prev_node->data);
 
-    Node* new_node = (Node*)mem_alloc(sizeof(Node));
+    Node* new_node = list_node_alloc();
     if (new_node == NULL) {
         printf("Memory allocation failed.\n");
         return;
@@ -76,7 +186,7 @@ void list_insert_before(Node** head, Node* next_node, uint16_t data) {
         return;
     }
 
-    Node* new_node = (Node*)mem_alloc(sizeof(Node));
+    Node* new_node = list_node_alloc();
     if (new_node == NULL) {
         printf("Memory allocation failed.\n");
         return;
@@ -97,7 +207,7 @@ void list_insert_before(Node** head, Node* next_node, uint16_t data) {
             temp->next = new_node;
         } else {
             printf("Next node not found in the list.\n");
-            mem_free(new_node);  // Free the memory if insertion fails
+            list_node_free(new_node);  // Free the memory if insertion fails
         }
     }
 }
@@ -131,7 +241,7 @@ void list_delete(Node** head, uint16_t data) {
         prev->next = temp->next;
     }
 
-    mem_free(temp);  // Free the memory of the node being deleted
+    list_node_free(temp);  // Free the memory of the node being deleted
 }
 
 // Search for a node with the specified data and return a pointer to it
@@ -150,90 +260,963 @@ Node* list_search(Node** head, uint16_t data) {
     return NULL;  // Node not found
 }
 
+/**
+ * Write nodes as "[a, b, c]" to a writer, without flushing it.
+ *
+ * @param writer: Writer to append to.
+ * @param start_node: First node to write, NULL for an empty list.
+ * @param end_node: Last node to write, NULL to write to the end of the list.
+ * @return false if a write has failed.
+ */
+bool list_write(ListWriter* writer, Node* start_node, Node* end_node) {
+    list_writer_write(writer, "[", 1);
+    ListCursor cursor;
+    list_cursor_init(&cursor, start_node);
+    for (Node* current; (current = list_cursor_next(&cursor)) != NULL;) {
+        list_writer_u16(writer, current->data);
+        if (current == end_node || current->next == NULL) {
+            break;
+        }
+        list_writer_write(writer, ", ", 2);
+    }
+    return list_writer_write(writer, "]", 1);
+}
+
+// Write the whole list to a file descriptor, e.g. to dump it to a file
+bool list_dump(Node** head, int fd) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return false;
+    }
+    list_writer_init(writer, fd);
+    list_write(writer, *head, NULL);
+    return list_writer_flush(writer);
+}
+
 // Display all nodes in the linked list
 void list_display(Node** head) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_write(writer, *head, NULL);
+    list_writer_flush(writer);
+}
+
+// Display the nodes in a range (from start_node to end_node)
+void list_display_range(Node** head, Node* start_node, Node* end_node) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_write(writer, start_node == NULL ? *head : start_node, end_node);
+    list_writer_flush(writer);
+}
+
+// Count the number of nodes in the list
+int list_count_nodes(Node** head) {
+    int count = 0;
     Node* temp = *head;
-    printf("[");  // Börja med en hakparentes
 
     while (temp != NULL) {
-        printf("Node: %p, Data: %d\n", (void*)temp, temp->data);  // Debugutskrift av nodens pekare och data
-        printf("%d", temp->data);  // Skriv ut data
-        if (temp->next != NULL) {
-            printf(", ");  // Endast lägg till ett kommatecken om det finns fler noder
-        }
+        count++;
         temp = temp->next;
     }
 
-    printf("]");  // Avsluta med en hakparentes
+    return count;
 }
 
+// Free all nodes in the linked list
+void list_cleanup(Node** head) {
+    Node* current = *head;
+    Node* next_node;
 
+    while (current != NULL) {
+        next_node = current->next;
+        list_node_free(current);  // Return the node to the arena or the pool
+        current = next_node;
+    }
 
+    *head = NULL;  // Set head to NULL after cleanup
+}
 
-// Display the nodes in a range (from start_node to end_node)
-#include <string.h>  // Ensure you include this for strcat and other string operations
-
-// Display the nodes in a range (from start_node to end_node)
-void list_display_range(Node** head, Node* start_node, Node* end_node) {
-    Node* current = (start_node == NULL) ? *head : start_node;
-    char output[1024] = "[";  // Start with an opening bracket
-    int first_node = 1;  // Flag to handle the first node correctly
+// Rebase the next pointers of a list restored from a pool snapshot that came
+// back at a different address (see mem_restore and mem_relocation_delta).
+// *head must already point into the restored pool, e.g. from mem_get_root().
+void list_relocate(Node** head, ptrdiff_t delta) {
+    if (delta == 0) {
+        return;
+    }
 
+    Node* current = *head;
     while (current != NULL) {
-        char temp[50];
+        if (current->next != NULL) {
+            current->next = (Node*)((char*)current->next + delta);
+        }
+        current = current->next;
+    }
+}
 
-        // If it's not the first node, add a comma
-        if (!first_node) {
-            strcat(output, ", ");
+// ********* Sorting *********
+
+// Sorted runs list_sort keeps, run i holding up to 2^i nodes; enough for any
+// list that fits in memory
+#define LIST_SORT_RUNS 64
+
+// Merge two sorted chains; on equal values a's nodes come first
+static Node* list_merge(Node* a, Node* b) {
+    Node merged;
+    Node* tail = &merged;
+    while (a != NULL && b != NULL) {
+        if (b->data < a->data) {
+            tail->next = b;
+            b = b->next;
         } else {
-            first_node = 0;  // Mark that the first node has been handled
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a != NULL ? a : b;
+    return merged.next;
+}
+
+/**
+ * Sort the list by value, in place, by relinking its nodes.
+ *
+ * Bottom-up merge sort: nodes are taken off the list one at a time and
+ * merged into runs of 1, 2, 4, ... nodes, kept in a fixed array on the
+ * stack. O(n log n) time, no allocation, stable. Lists with a descriptor
+ * must be passed to list_adopt afterwards to fix its tail and index.
+ *
+ * @param head: Pointer to the head pointer of the list.
+ */
+void list_sort(Node** head) {
+    Node* runs[LIST_SORT_RUNS] = {NULL};
+    int used = 0;
+    Node* node = *head;
+    while (node != NULL) {
+        Node* next = node->next;
+        node->next = NULL;
+        Node* carry = node;
+        int i = 0;
+        for (; i < used && runs[i] != NULL; i++) {
+            carry = list_merge(runs[i], carry);  // runs[i] holds earlier nodes
+            runs[i] = NULL;
+        }
+        if (i == used) {
+            used++;
+        }
+        runs[i] = carry;
+        node = next;
+    }
+
+    Node* sorted = NULL;
+    for (int i = 0; i < used; i++) {
+        sorted = list_merge(runs[i], sorted);
+    }
+    *head = sorted;
+}
+
+/**
+ * Sort the list by value, in place, with a two-pass LSD radix sort.
+ *
+ * Each pass deals the nodes into 256 buckets by one byte of their value,
+ * appending so equal bytes keep their order, and chains the buckets back
+ * together. O(n) time, stable, no allocation; a pass is skipped when every
+ * node has the same byte. Lists with a descriptor must be passed to
+ * list_adopt afterwards to fix its tail and index.
+ *
+ * @param head: Pointer to the head pointer of the list.
+ */
+void list_sort_radix(Node** head) {
+    Node* bucket_head[256];
+    Node** bucket_tail[256];
+    for (int shift = 0; shift < 16; shift += 8) {
+        if (*head == NULL) {
+            return;
+        }
+        for (int b = 0; b < 256; b++) {
+            bucket_tail[b] = &bucket_head[b];
         }
+        unsigned first = ((*head)->data >> shift) & 0xff;
+        bool mixed = false;
+        for (Node* node = *head; node != NULL; node = node->next) {
+            unsigned b = (node->data >> shift) & 0xff;
+            mixed |= b != first;
+            *bucket_tail[b] = node;
+            bucket_tail[b] = &node->next;
+        }
+        if (!mixed) {
+            continue;  // One bucket: the chain is unchanged
+        }
+        Node** link = head;
+        for (int b = 0; b < 256; b++) {
+            if (bucket_tail[b] != &bucket_head[b]) {
+                *link = bucket_head[b];
+                link = bucket_tail[b];
+            }
+        }
+        *link = NULL;
+    }
+}
 
-        // Add the node's data to the output
-        sprintf(temp, "%d", current->data);
-        strcat(output, temp);
+/**
+ * Start a cursor at a node. The first LIST_PREFETCH_DISTANCE nodes are
+ * prefetched here; from then on each list_cursor_next prefetches one more.
+ *
+ *     ListCursor cursor;
+ *     list_cursor_init(&cursor, list.head);
+ *     for (Node* node; (node = list_cursor_next(&cursor)) != NULL;) { ... }
+ *
+ * The list must not change while the cursor is in use.
+ *
+ * @param cursor: Cursor to set up.
+ * @param start_node: First node to return, NULL for an empty list.
+ */
+void list_cursor_init(ListCursor* cursor, Node* start_node) {
+    cursor->current = start_node;
+    Node* ahead = start_node;
+    for (int i = 0; i < LIST_PREFETCH_DISTANCE && ahead != NULL; i++) {
+        __builtin_prefetch(ahead);
+        ahead = ahead->next;
+    }
+    __builtin_prefetch(ahead);
+    cursor->ahead = ahead;
+}
 
-        // If we've reached the end node, break
-        if (current == end_node) {
+/**
+ * Call a function for each node, in list order, prefetching ahead of it.
+ *
+ * @param head: Pointer to the head pointer of the list.
+ * @param visit: Function to call; it may change the node's data but not the
+ *        links, and returns false to stop.
+ * @param ctx: Passed to visit.
+ * @return Number of nodes visited, including one that stopped the traversal.
+ */
+size_t list_foreach(Node** head, ListVisit visit, void* ctx) {
+    ListCursor cursor;
+    list_cursor_init(&cursor, *head);
+    size_t visited = 0;
+    for (Node* node; (node = list_cursor_next(&cursor)) != NULL;) {
+        visited++;
+        if (!visit(node, ctx)) {
             break;
         }
+    }
+    return visited;
+}
 
-        // Move to the next node
-        current = current->next;
+// ********* Descriptor-based API *********
+
+// Index entry for one node: where the node sits in the list and among the
+// other nodes holding the same value
+typedef struct ListIndexEntry {
+    Node* node;
+    Node* prev;                          // Predecessor in the list, NULL for the head
+    struct ListIndexEntry* next_same;    // Next node with the same value, in list order
+    struct ListIndexEntry* prev_same;    // Previous one; the first entry's is the last
+    struct ListIndexEntry* hash_next;    // Next entry in the same by_node bucket
+} ListIndexEntry;
+
+// Value index: first occurrence of every value, plus a table from node to
+// entry so predecessors can be found and kept up to date in O(1)
+struct ListIndex {
+    ListIndexEntry* first[UINT16_MAX + 1];
+    ListIndexEntry** by_node;    // Hash buckets keyed on the node address
+    size_t buckets;              // A power of two
+    size_t count;
+};
+
+static size_t index_bucket(const ListIndex* index, const Node* node) {
+    return (size_t)((((uintptr_t)node >> 3) * 0x9e3779b97f4a7c15ULL) >> 32) & (index->buckets - 1);
+}
+
+static ListIndexEntry* index_entry(const ListIndex* index, const Node* node) {
+    ListIndexEntry* entry = index->by_node[index_bucket(index, node)];
+    while (entry != NULL && entry->node != node) {
+        entry = entry->hash_next;
+    }
+    return entry;
+}
+
+// Doubles the node table once it averages one entry per bucket
+static bool index_grow(ListIndex* index) {
+    size_t old_buckets = index->buckets;
+    ListIndexEntry** old = index->by_node;
+    ListIndexEntry** by_node = calloc(old_buckets * 2, sizeof(ListIndexEntry*));
+    if (by_node == NULL) {
+        return false;
+    }
+    index->by_node = by_node;
+    index->buckets = old_buckets * 2;
+    for (size_t b = 0; b < old_buckets; b++) {
+        ListIndexEntry* entry = old[b];
+        while (entry != NULL) {
+            ListIndexEntry* next = entry->hash_next;
+            size_t bucket = index_bucket(index, entry->node);
+            entry->hash_next = by_node[bucket];
+            by_node[bucket] = entry;
+            entry = next;
+        }
+    }
+    free(old);
+    return true;
+}
+
+// Adds a node just linked in after prev. at_end means no indexed node follows
+// it, as when appending or building the index front to back. Only a duplicate
+// value inserted in the middle of the list costs a walk, to find its place
+// among the others.
+static bool index_add(List* list, Node* prev, Node* node, bool at_end) {
+    ListIndex* index = list->index;
+    if (index->count >= index->buckets && !index_grow(index)) {
+        return false;
+    }
+    ListIndexEntry* entry = malloc(sizeof(ListIndexEntry));
+    if (entry == NULL) {
+        return false;
+    }
+    entry->node = node;
+    entry->prev = prev;
+    size_t bucket = index_bucket(index, node);
+    entry->hash_next = index->by_node[bucket];
+    index->by_node[bucket] = entry;
+    index->count++;
+    if (!at_end) {
+        index_entry(index, node->next)->prev = node;
     }
 
-    strcat(output, "]");  // Close the bracket, but no newline
+    ListIndexEntry** first = &index->first[node->data];
+    if (*first == NULL) {
+        entry->next_same = NULL;
+        entry->prev_same = entry;
+        *first = entry;
+        return true;
+    }
 
-    // This returns the output that is captured by capture_stdout
-    printf("%s", output);
+    // Find the occurrence this one follows, if any
+    ListIndexEntry* after = NULL;
+    if (at_end) {
+        after = (*first)->prev_same;  // After the last one
+    } else if (prev != NULL) {
+        ListIndexEntry* same = *first;
+        for (Node* current = list->head; current != node && same != NULL; current = current->next) {
+            if (current == same->node) {
+                after = same;
+                same = same->next_same;
+            }
+        }
+    }
+
+    if (after == NULL) {
+        entry->next_same = *first;
+        entry->prev_same = (*first)->prev_same;
+        (*first)->prev_same = entry;
+        *first = entry;
+    } else {
+        entry->next_same = after->next_same;
+        entry->prev_same = after;
+        if (after->next_same != NULL) {
+            after->next_same->prev_same = entry;
+        } else {
+            (*first)->prev_same = entry;
+        }
+        after->next_same = entry;
+    }
+    return true;
 }
 
+// Drops the entry of a node that is about to be unlinked
+static void index_remove(ListIndex* index, ListIndexEntry* entry) {
+    Node* node = entry->node;
+    if (node->next != NULL) {
+        index_entry(index, node->next)->prev = entry->prev;
+    }
 
+    ListIndexEntry** first = &index->first[node->data];
+    if (*first == entry) {
+        *first = entry->next_same;
+        if (*first != NULL) {
+            (*first)->prev_same = entry->prev_same;
+        }
+    } else {
+        entry->prev_same->next_same = entry->next_same;
+        if (entry->next_same != NULL) {
+            entry->next_same->prev_same = entry->prev_same;
+        } else {
+            (*first)->prev_same = entry->prev_same;
+        }
+    }
 
-// Count the number of nodes in the list
-int list_count_nodes(Node** head) {
-    int count = 0;
-    Node* temp = *head;
+    ListIndexEntry** link = &index->by_node[index_bucket(index, node)];
+    while (*link != entry) {
+        link = &(*link)->hash_next;
+    }
+    *link = entry->hash_next;
+    index->count--;
+    free(entry);
+}
 
-    while (temp != NULL) {
-        count++;
+// Segment directory: the first node of every segment, in list order. Appends
+// start a new segment every LIST_SEGMENT_NODES nodes; inserts elsewhere make
+// their segment longer.
+struct ListSegments {
+    Node** starts;      // starts[0] is the head
+    size_t count;
+    size_t capacity;
+    size_t tail_run;    // Nodes appended to the last segment
+};
+
+static bool segments_push(ListSegments* segments, Node* start) {
+    if (segments->count == segments->capacity) {
+        size_t capacity = segments->capacity ? segments->capacity * 2 : 16;
+        Node** starts = realloc(segments->starts, capacity * sizeof(Node*));
+        if (starts == NULL) {
+            return false;
+        }
+        segments->starts = starts;
+        segments->capacity = capacity;
+    }
+    segments->starts[segments->count++] = start;
+    segments->tail_run = 1;
+    return true;
+}
+
+// Records a node just linked in after prev (at the head if prev is NULL).
+// at_end means it was appended.
+static bool segments_link(ListSegments* segments, Node* prev, Node* node, bool at_end) {
+    if (segments->count == 0) {
+        return segments_push(segments, node);
+    }
+    if (prev == NULL) {
+        segments->starts[0] = node;
+    } else if (at_end && ++segments->tail_run > LIST_SEGMENT_NODES) {
+        return segments_push(segments, node);
+    }
+    return true;
+}
+
+// Moves a segment start off a node about to be unlinked. O(segments).
+static void segments_unlink(ListSegments* segments, Node* node) {
+    for (size_t i = 0; i < segments->count; i++) {
+        if (segments->starts[i] != node) {
+            continue;
+        }
+        Node* next = node->next;
+        if (next == NULL || (i + 1 < segments->count && segments->starts[i + 1] == next)) {
+            // The segment is empty now
+            memmove(&segments->starts[i], &segments->starts[i + 1],
+                    (segments->count - i - 1) * sizeof(Node*));
+            segments->count--;
+            if (i == segments->count) {
+                segments->tail_run = LIST_SEGMENT_NODES;
+            }
+        } else {
+            segments->starts[i] = next;
+        }
+        return;
+    }
+}
+
+// Allocates and fills in a node, reporting failure like the Node** API does
+static Node* list_new_node(uint16_t data, Node* next) {
+    Node* new_node = list_node_alloc();
+    if (new_node == NULL) {
+        printf("Memory allocation for new node failed.\n");
+        return NULL;
+    }
+    new_node->data = data;
+    new_node->next = next;
+    return new_node;
+}
+
+// Links a new node in after prev (at the head if prev is NULL)
+static bool list_link(List* list, Node* prev, uint16_t data) {
+    Node* new_node = list_new_node(data, prev ? prev->next : list->head);
+    if (new_node == NULL) {
+        return false;
+    }
+    if (prev == NULL) {
+        list->head = new_node;
+    } else {
+        prev->next = new_node;
+    }
+    if (list->tail == prev) {
+        list->tail = new_node;
+    }
+    list->length++;
+
+    if (list->index != NULL && !index_add(list, prev, new_node, new_node->next == NULL)) {
+        printf("Out of memory for the value index; dropping it.\n");
+        list_index_disable(list);
+    }
+    if (list->segments != NULL && !segments_link(list->segments, prev, new_node, new_node->next == NULL)) {
+        printf("Out of memory for the segment directory; dropping it.\n");
+        list_segments_disable(list);
+    }
+    return true;
+}
+
+// Unlinks and frees the node after prev (the head if prev is NULL)
+static void list_unlink(List* list, Node* prev, Node* node) {
+    if (list->index != NULL) {
+        index_remove(list->index, index_entry(list->index, node));
+    }
+    if (list->segments != NULL) {
+        segments_unlink(list->segments, node);
+    }
+    if (prev == NULL) {
+        list->head = node->next;
+    } else {
+        prev->next = node->next;
+    }
+    if (list->tail == node) {
+        list->tail = prev;
+    }
+    list->length--;
+    list_node_free(node);
+}
+
+// Initialize an empty list descriptor and the memory pool behind it
+void list_create(List* list, size_t size) {
+    list_init(&list->head, size);
+    list->tail = NULL;
+    list->length = 0;
+    list->index = NULL;
+    list->segments = NULL;
+}
+
+// Take over an existing chain of nodes, e.g. one built with the Node** API.
+// The descriptor must come from list_create; an index or segment directory
+// it already has is rebuilt for the new nodes.
+void list_adopt(List* list, Node* head) {
+    bool indexed = list->index != NULL;
+    bool segmented = list->segments != NULL;
+    list_index_disable(list);
+    list_segments_disable(list);
+    list->head = head;
+    list->tail = NULL;
+    list->length = 0;
+    for (Node* current = head; current != NULL; current = current->next) {
+        list->tail = current;
+        list->length++;
+    }
+    if (indexed) {
+        list_index_enable(list);
+    }
+    if (segmented) {
+        list_segments_enable(list);
+    }
+}
+
+// Append a node in O(1)
+bool list_push_back(List* list, uint16_t data) {
+    return list_link(list, list->tail, data);
+}
+
+// Prepend a node in O(1)
+bool list_push_front(List* list, uint16_t data) {
+    return list_link(list, NULL, data);
+}
+
+// Insert a new node after a node of the list in O(1)
+bool list_insert_after_node(List* list, Node* prev_node, uint16_t data) {
+    if (prev_node == NULL) {
+        printf("Previous node cannot be NULL.\n");
+        return false;
+    }
+    return list_link(list, prev_node, data);
+}
+
+// Insert a new node before a node of the list; O(1) with an index, otherwise
+// O(n) to find its predecessor
+bool list_insert_before_node(List* list, Node* next_node, uint16_t data) {
+    if (list->head == NULL || next_node == NULL) {
+        return false;
+    }
+    if (list->index != NULL) {
+        ListIndexEntry* entry = index_entry(list->index, next_node);
+        if (entry == NULL) {
+            printf("Next node not found in the list.\n");
+            return false;
+        }
+        return list_link(list, entry->prev, data);
+    }
+    if (list->head == next_node) {
+        return list_push_front(list, data);
+    }
+
+    Node* temp = list->head;
+    while (temp != NULL && temp->next != next_node) {
+        temp = temp->next;
+    }
+    if (temp == NULL) {
+        printf("Next node not found in the list.\n");
+        return false;
+    }
+    return list_link(list, temp, data);
+}
+
+// Delete the first node with the specified data; O(1) with an index
+bool list_remove(List* list, uint16_t data) {
+    if (list->index != NULL) {
+        ListIndexEntry* entry = list->index->first[data];
+        if (entry == NULL) {
+            return false;
+        }
+        list_unlink(list, entry->prev, entry->node);
+        return true;
+    }
+
+    Node* temp = list->head;
+    Node* prev = NULL;
+    while (temp != NULL && temp->data != data) {
+        prev = temp;
         temp = temp->next;
     }
+    if (temp == NULL) {
+        return false;
+    }
+    list_unlink(list, prev, temp);
+    return true;
+}
 
+// Search for the first node with the specified data, without printing;
+// O(1) with an index
+Node* list_find(const List* list, uint16_t data) {
+    if (list->index != NULL) {
+        ListIndexEntry* entry = list->index->first[data];
+        return entry ? entry->node : NULL;
+    }
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (current->data == data) {
+            return current;
+        }
+    }
+    return NULL;
+}
+
+// Number of nodes in O(1)
+size_t list_length(const List* list) {
+    return list->length;
+}
+
+// Free all nodes and leave the descriptor empty
+void list_destroy(List* list) {
+    list_index_disable(list);
+    list_segments_disable(list);
+    list_cleanup(&list->head);
+    list->tail = NULL;
+    list->length = 0;
+}
+
+/**
+ * Relay the list out in traversal order so walking it touches memory
+ * sequentially instead of missing the cache on every hop.
+ *
+ * The nodes are copied, in list order, into one contiguous run of a fresh
+ * node arena sized for the list, linked to each other, and the old nodes
+ * are freed; arenas they leave empty go back to the pool. The pause is one
+ * walk to check the length and one to copy.
+ *
+ * Node pointers into the list are invalid afterwards. The value index and
+ * segment directory are rebuilt if the list had them.
+ *
+ * @param list: List to compact.
+ * @return false if the list does not end after list->length nodes (after
+ *         changes through the Node** API without list_adopt) or there is no
+ *         room for the new arena, in which case the list is unchanged; also
+ *         false if the index or segment directory could not be rebuilt, in
+ *         which case the list is compacted without it.
+ */
+bool list_compact(List* list) {
+    size_t count = 0;
+    for (Node* node = list->head; node != NULL && count <= list->length; node = node->next) {
+        count++;
+    }
+    if (count != list->length) {
+        printf("List length is out of date; list_adopt the list before compacting it.\n");
+        return false;
+    }
+    if (list->length == 0) {
+        return true;
+    }
+
+    NodeArena* arena = node_arena_create(sizeof(Node), list->length);
+    if (arena == NULL) {
+        return false;
+    }
+    if (!list_arena_add(arena)) {
+        node_arena_destroy(arena);
+        return false;
+    }
+    size_t taken;
+    Node* run = (Node*)node_arena_alloc_run(arena, list->length, &taken);
+
+    bool indexed = list->index != NULL;
+    bool segmented = list->segments != NULL;
+    list_index_disable(list);
+    list_segments_disable(list);
+    Node* current = list->head;
+    for (size_t i = 0; i < taken; i++) {
+        Node* next = current->next;
+        run[i].data = current->data;
+        run[i].next = &run[i + 1];
+        list_node_free(current);
+        current = next;
+    }
+    run[taken - 1].next = NULL;
+    list->head = run;
+    list->tail = &run[taken - 1];
+    list_arenas_sweep();
+
+    bool ok = true;
+    if (indexed && !list_index_enable(list)) {
+        ok = false;
+    }
+    if (segmented && !list_segments_enable(list)) {
+        ok = false;
+    }
+    return ok;
+}
+
+// Updates the index and segment directory for nodes just appended after prev
+static void list_track_appended(List* list, Node* prev, Node* first) {
+    for (Node* node = first; node != NULL; prev = node, node = node->next) {
+        if (list->index != NULL && !index_add(list, prev, node, true)) {
+            printf("Out of memory for the value index; dropping it.\n");
+            list_index_disable(list);
+        }
+        if (list->segments != NULL && !segments_link(list->segments, prev, node, true)) {
+            printf("Out of memory for the segment directory; dropping it.\n");
+            list_segments_disable(list);
+        }
+    }
+}
+
+/**
+ * Build a list from an array in one pass. Like list_create, this sets up
+ * the memory pool, sized so every node comes from one contiguous run of the
+ * node arena.
+ *
+ * @param list: Descriptor to initialize.
+ * @param values: Values in list order.
+ * @param count: Number of values.
+ * @return false if not every value could be added.
+ */
+bool list_from_array(List* list, const uint16_t* values, size_t count) {
+    list_create(list, count * sizeof(Node));
+    return list_insert_bulk(list, values, count);
+}
+
+/**
+ * Append an array of values in one pass. Nodes are taken from the node
+ * arena's never-used slots as one contiguous run and filled in a single
+ * loop; once those run out, the rest come one at a time from the arena's
+ * freed slots or the pool.
+ *
+ * @param list: List to append to.
+ * @param values: Values in list order.
+ * @param count: Number of values.
+ * @return false if memory ran out; the values before that are appended.
+ */
+bool list_insert_bulk(List* list, const uint16_t* values, size_t count) {
+    NodeArena* arena = list_arena();
+    Node* prev = list->tail;
+    Node* last = prev;
+    size_t done = 0;
+    while (done < count) {
+        size_t taken = 0;
+        Node* run = arena ? (Node*)node_arena_alloc_run(arena, count - done, &taken) : NULL;
+        if (run != NULL) {
+            for (size_t i = 0; i < taken; i++) {
+                run[i].data = values[done + i];
+                run[i].next = &run[i + 1];
+            }
+            run[taken - 1].next = NULL;
+        } else {
+            run = list_new_node(values[done], NULL);
+            if (run == NULL) {
+                break;
+            }
+            taken = 1;
+        }
+        if (last == NULL) {
+            list->head = run;
+        } else {
+            last->next = run;
+        }
+        last = &run[taken - 1];
+        done += taken;
+    }
+    list->tail = last;
+    list->length += done;
+    if (list->index != NULL || list->segments != NULL) {
+        list_track_appended(list, prev, prev ? prev->next : list->head);
+    }
+    return done == count;
+}
+
+// Whether the count nodes from node on sit next to each other in memory, in
+// list order. Each link is checked before the node it points to is read.
+static inline bool list_run_contiguous(const Node* node, int count) {
+    for (int i = 0; i < count - 1; i++) {
+        if (node[i].next != &node[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Copy a list's values into a buffer, in list order. Runs of eight nodes
+ * that sit next to each other in memory, as nodes from list_from_array,
+ * list_insert_bulk or list_compact do, are gathered and stored with vector
+ * instructions where available.
+ *
+ * @param list: List to export.
+ * @param buffer: Receives the values.
+ * @param capacity: Values the buffer holds.
+ * @return Number of values written: the list's length, or capacity if the
+ *         list is longer.
+ */
+size_t list_to_array(const List* list, uint16_t* buffer, size_t capacity) {
+    size_t count = 0;
+    const Node* node = list->head;
+    while (node != NULL && count < capacity) {
+#ifdef __SSE2__
+        if (sizeof(Node) == 16 && capacity - count >= 8 && list_run_contiguous(node, 8)) {
+            // The data fields are the low 16 bits of each 16-byte node
+            const __m128i* nodes = (const __m128i*)node;
+            __m128i d01 = _mm_unpacklo_epi16(_mm_loadu_si128(nodes), _mm_loadu_si128(nodes + 1));
+            __m128i d23 = _mm_unpacklo_epi16(_mm_loadu_si128(nodes + 2), _mm_loadu_si128(nodes + 3));
+            __m128i d45 = _mm_unpacklo_epi16(_mm_loadu_si128(nodes + 4), _mm_loadu_si128(nodes + 5));
+            __m128i d67 = _mm_unpacklo_epi16(_mm_loadu_si128(nodes + 6), _mm_loadu_si128(nodes + 7));
+            __m128i values = _mm_unpacklo_epi64(_mm_unpacklo_epi32(d01, d23), _mm_unpacklo_epi32(d45, d67));
+            _mm_storeu_si128((__m128i*)(buffer + count), values);
+            count += 8;
+            node = node[7].next;
+            continue;
+        }
+#endif
+        buffer[count++] = node->data;
+        node = node->next;
+    }
     return count;
 }
 
-// Free all nodes in the linked list
-void list_cleanup(Node** head) {
-    Node* current = *head;
-    Node* next_node;
+/**
+ * Builds a value index for the list and keeps it up to date from then on.
+ *
+ * list_find, list_remove and list_insert_before_node then run in O(1)
+ * expected time. The index lives on the process heap, not in the pool, and
+ * costs a 512 KiB first-occurrence table plus one entry per node. The
+ * list must only be changed through the List functions while it is indexed.
+ *
+ * @return: true if the index was built (or already existed).
+ */
+bool list_index_enable(List* list) {
+    if (list->index != NULL) {
+        return true;
+    }
+    ListIndex* index = calloc(1, sizeof(ListIndex));
+    if (index == NULL) {
+        printf("Memory allocation for the value index failed.\n");
+        return false;
+    }
+    index->buckets = 64;
+    index->by_node = calloc(index->buckets, sizeof(ListIndexEntry*));
+    if (index->by_node == NULL) {
+        free(index);
+        printf("Memory allocation for the value index failed.\n");
+        return false;
+    }
 
-    while (current != NULL) {
-        next_node = current->next;
-        mem_free(current);  // Use custom memory manager to free memory
-        current = next_node;
+    list->index = index;
+    Node* prev = NULL;
+    for (Node* current = list->head; current != NULL; prev = current, current = current->next) {
+        if (!index_add(list, prev, current, true)) {
+            list_index_disable(list);
+            printf("Memory allocation for the value index failed.\n");
+            return false;
+        }
     }
+    return true;
+}
 
-    *head = NULL;  // Set head to NULL after cleanup
+// Drop the value index; the list goes back to linear searches
+void list_index_disable(List* list) {
+    ListIndex* index = list->index;
+    if (index == NULL) {
+        return;
+    }
+    for (size_t b = 0; b < index->buckets; b++) {
+        ListIndexEntry* entry = index->by_node[b];
+        while (entry != NULL) {
+            ListIndexEntry* next = entry->hash_next;
+            free(entry);
+            entry = next;
+        }
+    }
+    free(index->by_node);
+    free(index);
+    list->index = NULL;
 }
 
+/**
+ * Builds a segment directory for the list and keeps it up to date from then
+ * on: the first node of every run of about LIST_SEGMENT_NODES nodes, so
+ * threads can start walking the list in many places at once (see
+ * list_parallel.h).
+ *
+ * Appending keeps the segments even. Inserting elsewhere makes a segment
+ * longer, and unlinking a node costs a scan of the directory, one pointer
+ * per segment. The list must only be changed through the List functions
+ * while it has a directory. Calling this again rebuilds it.
+ *
+ * @return: true if the directory was built.
+ */
+bool list_segments_enable(List* list) {
+    list_segments_disable(list);
+    ListSegments* segments = calloc(1, sizeof(ListSegments));
+    if (segments == NULL) {
+        printf("Memory allocation for the segment directory failed.\n");
+        return false;
+    }
+    size_t run = 0;
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (run++ % LIST_SEGMENT_NODES == 0 && !segments_push(segments, current)) {
+            free(segments->starts);
+            free(segments);
+            printf("Memory allocation for the segment directory failed.\n");
+            return false;
+        }
+    }
+    segments->tail_run = (run - 1) % LIST_SEGMENT_NODES + 1;
+    list->segments = segments;
+    return true;
+}
+
+// Drop the segment directory
+void list_segments_disable(List* list) {
+    if (list->segments == NULL) {
+        return;
+    }
+    free(list->segments->starts);
+    free(list->segments);
+    list->segments = NULL;
+}
+
+// Number of segments in the directory, 0 if the list has none
+size_t list_segment_count(const List* list) {
+    return list->segments != NULL ? list->segments->count : 0;
+}
+
+// First node of a segment, or NULL past the last one. A segment ends where
+// the next one starts.
+Node* list_segment_start(const List* list, size_t segment) {
+    return segment < list_segment_count(list) ? list->segments->starts[segment] : NULL;
+}
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include "list_writer.h"
 
 // Define the Node structure for the singly linked list
 typedef struct Node {
@@ -10,6 +12,37 @@ typedef struct Node {
     struct Node* next; // Pointer to the next node
 } Node;
 
+typedef struct ListIndex ListIndex;
+typedef struct ListSegments ListSegments;
+
+// Nodes per segment of a segment directory (see list_segments_enable)
+#define LIST_SEGMENT_NODES 4096
+
+// Called for each node by list_foreach; returns false to stop the traversal
+typedef bool (*ListVisit)(Node* node, void* ctx);
+
+// Hops list cursors run ahead of the node they return, prefetching
+#define LIST_PREFETCH_DISTANCE 8
+
+// Iterator over a Node list (see list_cursor_init). A second pointer runs
+// LIST_PREFETCH_DISTANCE nodes ahead and prefetches, so each node is already
+// being fetched while the caller works on the ones before it.
+typedef struct ListCursor {
+    Node* current;      // Node the next call returns, NULL at the end
+    Node* ahead;        // Node being prefetched, NULL once past the end
+} ListCursor;
+
+// List descriptor: keeps the tail and length next to the head so appending
+// and counting are O(1). &list->head can be passed to the Node** functions
+// that do not change the list (search, display, count).
+typedef struct List {
+    Node* head;         // First node, NULL if the list is empty
+    Node* tail;         // Last node, NULL if the list is empty
+    size_t length;      // Number of nodes
+    ListIndex* index;   // Optional value index (see list_index_enable), NULL if none
+    ListSegments* segments;  // Optional segment directory (see list_segments_enable), NULL if none
+} List;
+
 void list_init(Node** head, size_t size);
 void list_insert(Node** head, uint16_t data);
 void list_insert_after(Node* prev_node, uint16_t data);
@@ -18,8 +51,51 @@ void list_delete(Node** head, uint16_t data);
 Node* list_search(Node** head, uint16_t data);
 void list_display(Node** head);
 void list_display_range(Node** head, Node* start_node, Node* end_node);
+bool list_write(ListWriter* writer, Node* start_node, Node* end_node);
+bool list_dump(Node** head, int fd);
 int list_count_nodes(Node** head);
 void list_cleanup(Node** head);
+void list_relocate(Node** head, ptrdiff_t delta);
+void list_sort(Node** head);
+void list_sort_radix(Node** head);
+size_t list_foreach(Node** head, ListVisit visit, void* ctx);
+void list_cursor_init(ListCursor* cursor, Node* start_node);
+
+// Descriptor-based API
+void list_create(List* list, size_t size);
+void list_adopt(List* list, Node* head);
+bool list_push_back(List* list, uint16_t data);
+bool list_push_front(List* list, uint16_t data);
+bool list_insert_after_node(List* list, Node* prev_node, uint16_t data);
+bool list_insert_before_node(List* list, Node* next_node, uint16_t data);
+bool list_remove(List* list, uint16_t data);
+Node* list_find(const List* list, uint16_t data);
+size_t list_length(const List* list);
+void list_destroy(List* list);
+bool list_compact(List* list);
+bool list_from_array(List* list, const uint16_t* values, size_t count);
+bool list_insert_bulk(List* list, const uint16_t* values, size_t count);
+size_t list_to_array(const List* list, uint16_t* buffer, size_t capacity);
+bool list_index_enable(List* list);
+void list_index_disable(List* list);
+bool list_segments_enable(List* list);
+void list_segments_disable(List* list);
+size_t list_segment_count(const List* list);
+Node* list_segment_start(const List* list, size_t segment);
+
+// Next node of a cursor, or NULL at the end of the list
+static inline Node* list_cursor_next(ListCursor* cursor) {
+    Node* node = cursor->current;
+    if (node == NULL) {
+        return NULL;
+    }
+    cursor->current = node->next;
+    if (cursor->ahead != NULL) {
+        cursor->ahead = cursor->ahead->next;
+        __builtin_prefetch(cursor->ahead);
+    }
+    return node;
+}
 
 #endif 
 
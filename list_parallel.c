@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "list_parallel.h"
+
+// One reduction in progress: the partial results sit on separate cache lines
+typedef struct ReduceRun {
+    const List* list;
+    const ListReduce* reduce;
+    char* partials;
+    size_t stride;      // Bytes from one partial result to the next
+} ReduceRun;
+
+static void reduce_segment(size_t segment, int worker, void* ctx) {
+    ReduceRun* run = ctx;
+    run->reduce->fold(run->partials + (size_t)worker * run->stride, list_segment_start(run->list, segment),
+                      list_segment_start(run->list, segment + 1), run->reduce->ctx);
+}
+
+/**
+ * Compute an aggregate over a list by folding its segments on a pool's
+ * threads.
+ *
+ * The list gets a segment directory (see list_segments_enable) if it has
+ * none, and a new one if inserts away from the tail have made its segments
+ * more than twice LIST_SEGMENT_NODES long on average. Both take one walk
+ * over the list; later calls reuse the directory. The list must not change
+ * during the call.
+ *
+ * @param list: List to aggregate.
+ * @param pool: Threads to use, NULL to fold every segment on the calling thread.
+ * @param reduce: How to compute the aggregate; reduce->size must not be 0.
+ * @param result: Receives the aggregate, reduce->size bytes.
+ * @return false if memory for the directory or the partial results ran out.
+ */
+bool list_parallel_reduce(List* list, ThreadPool* pool, const ListReduce* reduce, void* result) {
+    if (list->segments == NULL || list->length > 2 * LIST_SEGMENT_NODES * list_segment_count(list)) {
+        if (!list_segments_enable(list)) {
+            return false;
+        }
+    }
+    int threads = pool != NULL ? thread_pool_size(pool) : 1;
+    ReduceRun run = {list, reduce, NULL, (reduce->size + 63) & ~(size_t)63};
+    run.partials = aligned_alloc(64, run.stride * threads);
+    if (run.partials == NULL) {
+        printf("Memory allocation for the partial results failed.\n");
+        return false;
+    }
+    for (int t = 0; t < threads; t++) {
+        reduce->init(run.partials + (size_t)t * run.stride, reduce->ctx);
+    }
+
+    size_t segments = list_segment_count(list);
+    if (pool != NULL) {
+        thread_pool_run(pool, segments, reduce_segment, &run);
+    } else {
+        for (size_t s = 0; s < segments; s++) {
+            reduce_segment(s, 0, &run);
+        }
+    }
+
+    reduce->init(result, reduce->ctx);
+    for (int t = 0; t < threads; t++) {
+        reduce->combine(result, run.partials + (size_t)t * run.stride, reduce->ctx);
+    }
+    free(run.partials);
+    return true;
+}
+
+// ********* Common aggregates *********
+
+static void sum_init(void* partial, void* ctx) {
+    (void)ctx;
+    *(uint64_t*)partial = 0;
+}
+
+static void sum_fold(void* partial, const Node* first, const Node* stop, void* ctx) {
+    (void)ctx;
+    uint64_t sum = 0;
+    for (const Node* node = first; node != stop; node = node->next) {
+        sum += node->data;
+    }
+    *(uint64_t*)partial += sum;
+}
+
+static void sum_combine(void* into, const void* partial, void* ctx) {
+    (void)ctx;
+    *(uint64_t*)into += *(const uint64_t*)partial;
+}
+
+// Sum of all values; 0 for an empty list or if memory ran out
+uint64_t list_parallel_sum(List* list, ThreadPool* pool) {
+    ListReduce reduce = {sizeof(uint64_t), sum_init, sum_fold, sum_combine, NULL};
+    uint64_t sum;
+    return list_parallel_reduce(list, pool, &reduce, &sum) ? sum : 0;
+}
+
+typedef struct MinMax {
+    uint16_t min;
+    uint16_t max;
+} MinMax;
+
+static void minmax_init(void* partial, void* ctx) {
+    (void)ctx;
+    MinMax* minmax = partial;
+    minmax->min = UINT16_MAX;
+    minmax->max = 0;
+}
+
+static void minmax_fold(void* partial, const Node* first, const Node* stop, void* ctx) {
+    (void)ctx;
+    MinMax* minmax = partial;
+    uint16_t min = minmax->min;
+    uint16_t max = minmax->max;
+    for (const Node* node = first; node != stop; node = node->next) {
+        min = node->data < min ? node->data : min;
+        max = node->data > max ? node->data : max;
+    }
+    minmax->min = min;
+    minmax->max = max;
+}
+
+static void minmax_combine(void* into, const void* partial, void* ctx) {
+    (void)ctx;
+    MinMax* minmax = into;
+    const MinMax* other = partial;
+    minmax->min = other->min < minmax->min ? other->min : minmax->min;
+    minmax->max = other->max > minmax->max ? other->max : minmax->max;
+}
+
+/**
+ * Smallest and largest value of a list.
+ *
+ * @return false if the list is empty or memory ran out; min and max are
+ *         left unchanged then.
+ */
+bool list_parallel_minmax(List* list, ThreadPool* pool, uint16_t* min, uint16_t* max) {
+    ListReduce reduce = {sizeof(MinMax), minmax_init, minmax_fold, minmax_combine, NULL};
+    MinMax minmax;
+    if (list->length == 0 || !list_parallel_reduce(list, pool, &reduce, &minmax)) {
+        return false;
+    }
+    *min = minmax.min;
+    *max = minmax.max;
+    return true;
+}
+
+static void histogram_init(void* partial, void* ctx) {
+    memset(partial, 0, *(unsigned*)ctx * sizeof(uint64_t));
+}
+
+static void histogram_fold(void* partial, const Node* first, const Node* stop, void* ctx) {
+    uint64_t* counts = partial;
+    unsigned buckets = *(unsigned*)ctx;
+    for (const Node* node = first; node != stop; node = node->next) {
+        counts[((uint32_t)node->data * buckets) >> 16]++;
+    }
+}
+
+static void histogram_combine(void* into, const void* partial, void* ctx) {
+    uint64_t* counts = into;
+    const uint64_t* other = partial;
+    for (unsigned b = 0; b < *(unsigned*)ctx; b++) {
+        counts[b] += other[b];
+    }
+}
+
+/**
+ * Count the values falling in each of a number of equal-width buckets
+ * spanning 0 to UINT16_MAX; value v goes to bucket v * buckets / 65536.
+ *
+ * @param counts: Receives the count of every bucket.
+ * @param buckets: Number of buckets, 1 to 65536.
+ * @return false if buckets is out of range or memory ran out.
+ */
+bool list_parallel_histogram(List* list, ThreadPool* pool, uint64_t* counts, unsigned buckets) {
+    if (buckets == 0 || buckets > 65536) {
+        printf("Invalid number of histogram buckets: %u.\n", buckets);
+        return false;
+    }
+    ListReduce reduce = {buckets * sizeof(uint64_t), histogram_init, histogram_fold, histogram_combine, &buckets};
+    return list_parallel_reduce(list, pool, &reduce, counts);
+}
+
+typedef struct CountIf {
+    bool (*match)(uint16_t data, void* ctx);
+    void* ctx;
+} CountIf;
+
+static void count_init(void* partial, void* ctx) {
+    (void)ctx;
+    *(size_t*)partial = 0;
+}
+
+static void count_fold(void* partial, const Node* first, const Node* stop, void* ctx) {
+    CountIf* count_if = ctx;
+    size_t count = 0;
+    for (const Node* node = first; node != stop; node = node->next) {
+        count += count_if->match(node->data, count_if->ctx);
+    }
+    *(size_t*)partial += count;
+}
+
+static void count_combine(void* into, const void* partial, void* ctx) {
+    (void)ctx;
+    *(size_t*)into += *(const size_t*)partial;
+}
+
+// Number of values a function matches; 0 if memory ran out. match may run on
+// several threads at once.
+size_t list_parallel_count_if(List* list, ThreadPool* pool, bool (*match)(uint16_t data, void* ctx), void* ctx) {
+    CountIf count_if = {match, ctx};
+    ListReduce reduce = {sizeof(size_t), count_init, count_fold, count_combine, &count_if};
+    size_t count;
+    return list_parallel_reduce(list, pool, &reduce, &count) ? count : 0;
+}
@@ -0,0 +1,33 @@
+#ifndef LIST_PARALLEL_H
+#define LIST_PARALLEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "linked_list.h"
+#include "thread_pool.h"
+
+// Aggregate over a list, computed as one partial result per thread. Every
+// segment of the list is folded into the partial result of the thread that
+// runs it, and the partial results are then combined into one. Segments go to
+// threads in no fixed order, so combine must not depend on the order.
+typedef struct ListReduce {
+    size_t size;    // Bytes of a partial result
+    // Set a partial result to the value for no nodes
+    void (*init)(void* partial, void* ctx);
+    // Fold the nodes from first up to (not including) stop into a partial result
+    void (*fold)(void* partial, const Node* first, const Node* stop, void* ctx);
+    // Merge a partial result into another
+    void (*combine)(void* into, const void* partial, void* ctx);
+    void* ctx;      // Passed to the functions above
+} ListReduce;
+
+bool list_parallel_reduce(List* list, ThreadPool* pool, const ListReduce* reduce, void* result);
+
+// Common aggregates
+uint64_t list_parallel_sum(List* list, ThreadPool* pool);
+bool list_parallel_minmax(List* list, ThreadPool* pool, uint16_t* min, uint16_t* max);
+bool list_parallel_histogram(List* list, ThreadPool* pool, uint64_t* counts, unsigned buckets);
+size_t list_parallel_count_if(List* list, ThreadPool* pool, bool (*match)(uint16_t data, void* ctx), void* ctx);
+
+#endif
@@ -0,0 +1,139 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include "list_writer.h"
+
+const char list_writer_digits[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Start an empty writer that sends its output to a file descriptor
+void list_writer_init(ListWriter* writer, int fd) {
+    writer->fd = fd;
+    writer->file = NULL;
+    writer->used = 0;
+    writer->failed = false;
+}
+
+// Start an empty writer that sends its output to a stream. It goes through
+// fwrite so it stays in order with other output on the stream.
+void list_writer_init_file(ListWriter* writer, FILE* file) {
+    list_writer_init(writer, -1);
+    writer->file = file;
+}
+
+// Each thread's shared writer, allocated the first time the thread asks for
+// it so threads that never write a list do not carry its buffer
+static __thread ListWriter* shared_writer = NULL;
+static pthread_key_t shared_writer_key;    // Flushes and frees it when the thread exits
+static pthread_once_t shared_writer_once = PTHREAD_ONCE_INIT;
+
+static void shared_writer_release(void* writer) {
+    list_writer_flush(writer);
+    free(writer);
+    shared_writer = NULL;
+}
+
+static void shared_writer_key_create(void) {
+    pthread_key_create(&shared_writer_key, shared_writer_release);
+}
+
+// Writer for the calling thread, reused so dumping a list does not allocate
+// after the first time. Point it at its target with list_writer_init or
+// list_writer_init_file. NULL if it could not be allocated.
+ListWriter* list_writer_shared(void) {
+    if (shared_writer == NULL) {
+        ListWriter* writer = malloc(sizeof(ListWriter));
+        if (writer == NULL) {
+            printf("Memory allocation for the list writer failed.\n");
+            return NULL;
+        }
+        list_writer_init(writer, -1);
+        pthread_once(&shared_writer_once, shared_writer_key_create);
+        pthread_setspecific(shared_writer_key, writer);
+        shared_writer = writer;
+    }
+    return shared_writer;
+}
+
+// Write all of iov to the fd, retrying after short writes and signals
+static bool write_all(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+    return true;
+}
+
+// Send the buffer followed by data, in one system call when writing to an fd
+static bool list_writer_send(ListWriter* writer, const char* data, size_t size) {
+    if (writer->failed) {
+        writer->used = 0;
+        return false;
+    }
+    bool ok;
+    if (writer->file != NULL) {
+        ok = fwrite(writer->buffer, 1, writer->used, writer->file) == writer->used &&
+             fwrite(data, 1, size, writer->file) == size;
+    } else {
+        struct iovec iov[2] = {
+            {writer->buffer, writer->used},
+            {(void*)data, size},
+        };
+        ok = write_all(writer->fd, iov, 2);
+    }
+    writer->used = 0;
+    writer->failed = !ok;
+    return ok;
+}
+
+/**
+ * Append bytes to the writer. Data too large for the space left in the
+ * buffer is written out together with the buffer instead of being copied.
+ *
+ * @param writer: Writer to append to.
+ * @param data: Bytes to append.
+ * @param size: Number of bytes.
+ * @return false if a write has failed.
+ */
+bool list_writer_write(ListWriter* writer, const char* data, size_t size) {
+    if (size <= LIST_WRITER_BUFFER - writer->used) {
+        memcpy(writer->buffer + writer->used, data, size);
+        writer->used += size;
+        return !writer->failed;
+    }
+    return list_writer_send(writer, data, size);
+}
+
+// Write out everything buffered; false if any write has failed
+bool list_writer_flush(ListWriter* writer) {
+    if (writer->used == 0) {
+        return !writer->failed;
+    }
+    return list_writer_send(writer, NULL, 0);
+}
@@ -0,0 +1,65 @@
+#ifndef LIST_WRITER_H
+#define LIST_WRITER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Bytes a writer collects before handing them to the fd or FILE*
+#define LIST_WRITER_BUFFER (64 * 1024)
+
+// Longest text of one value, "65535"
+#define LIST_WRITER_U16_MAX 5
+
+// Buffered output for dumping lists. Values are formatted straight into the
+// buffer, which goes out in one write (or fwrite) call per LIST_WRITER_BUFFER
+// bytes instead of one or more printf calls per value.
+typedef struct ListWriter {
+    int fd;             // Target file descriptor, -1 when writing to file
+    FILE* file;         // Target stream, NULL when writing to fd
+    size_t used;        // Bytes waiting in buffer
+    bool failed;        // A write failed; later output is dropped
+    char buffer[LIST_WRITER_BUFFER];
+} ListWriter;
+
+void list_writer_init(ListWriter* writer, int fd);
+void list_writer_init_file(ListWriter* writer, FILE* file);
+ListWriter* list_writer_shared(void);
+bool list_writer_write(ListWriter* writer, const char* data, size_t size);
+bool list_writer_flush(ListWriter* writer);
+
+// "00" to "99", two characters per pair
+extern const char list_writer_digits[200];
+
+// Append a string
+static inline void list_writer_puts(ListWriter* writer, const char* text) {
+    list_writer_write(writer, text, strlen(text));
+}
+
+// Append a value in decimal, two digits per table lookup
+static inline void list_writer_u16(ListWriter* writer, uint16_t value) {
+    if (writer->used > LIST_WRITER_BUFFER - LIST_WRITER_U16_MAX) {
+        list_writer_flush(writer);
+    }
+    char digits[LIST_WRITER_U16_MAX];
+    char* start = digits + LIST_WRITER_U16_MAX;
+    unsigned rest = value;
+    while (rest >= 100) {
+        start -= 2;
+        memcpy(start, &list_writer_digits[(rest % 100) * 2], 2);
+        rest /= 100;
+    }
+    if (rest >= 10) {
+        start -= 2;
+        memcpy(start, &list_writer_digits[rest * 2], 2);
+    } else {
+        *--start = (char)('0' + rest);
+    }
+    size_t length = (size_t)(digits + LIST_WRITER_U16_MAX - start);
+    memcpy(writer->buffer + writer->used, start, length);
+    writer->used += length;
+}
+
+#endif
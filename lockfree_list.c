@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <pthread.h>
+#include "memory_manager.h"
+#include "lockfree_list.h"
+#include "epoch.h"
+
+#define LF_MARK ((uintptr_t)1)
+
+static inline LfNode* lf_pointer(uintptr_t link) {
+    return (LfNode*)(link & ~LF_MARK);
+}
+
+static inline bool lf_marked(uintptr_t link) {
+    return (link & LF_MARK) != 0;
+}
+
+static inline uintptr_t lf_load(const uintptr_t* link) {
+    return __atomic_load_n(link, __ATOMIC_ACQUIRE);
+}
+
+static inline bool lf_cas(uintptr_t* link, uintptr_t expected, uintptr_t desired) {
+    return __atomic_compare_exchange_n(link, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+// Reclaimed nodes a thread keeps for its own inserts. Epoch reclamation frees
+// nodes in bursts, whenever the epoch moves on, which would overflow the
+// pool's thread cache and send most frees through the pool lock.
+#define LF_SPARE_MAX 1024
+
+typedef struct LfSpare {
+    LfNode* head;           // Nodes linked through next
+    unsigned count;
+    unsigned generation;    // mem_pool_generation the nodes belong to
+} LfSpare;
+
+static __thread LfSpare lf_spare;
+static pthread_key_t lf_spare_key;     // Returns a thread's spare nodes when it exits
+static pthread_once_t lf_spare_once = PTHREAD_ONCE_INIT;
+
+// Give the calling thread's spare nodes back to the pool, if it still exists
+static void lf_spare_release(void* spare) {
+    (void)spare;
+    bool current = lf_spare.generation == __atomic_load_n(&mem_pool_generation, __ATOMIC_ACQUIRE);
+    while (lf_spare.head != NULL) {
+        LfNode* node = lf_spare.head;
+        lf_spare.head = (LfNode*)node->next;
+        if (current) {
+            mem_free(node);
+        }
+    }
+    lf_spare.count = 0;
+}
+
+static void lf_spare_key_create(void) {
+    pthread_key_create(&lf_spare_key, lf_spare_release);
+}
+
+// Drop nodes of a pool that is gone
+static inline void lf_spare_check(void) {
+    unsigned generation = __atomic_load_n(&mem_pool_generation, __ATOMIC_ACQUIRE);
+    if (lf_spare.generation != generation) {
+        lf_spare.head = NULL;
+        lf_spare.count = 0;
+        lf_spare.generation = generation;
+    }
+}
+
+static LfNode* lf_node_alloc(void) {
+    lf_spare_check();
+    if (lf_spare.head != NULL) {
+        LfNode* node = lf_spare.head;
+        lf_spare.head = (LfNode*)node->next;
+        lf_spare.count--;
+        return node;
+    }
+    return mem_alloc_inline(sizeof(LfNode));
+}
+
+static void lf_node_free(void* node) {
+    lf_spare_check();
+    if (lf_spare.count < LF_SPARE_MAX) {
+        if (lf_spare.count == 0) {
+            // Arm the exit handler again; nodes can arrive from other exit
+            // handlers (epoch reclamation) after it has run
+            pthread_once(&lf_spare_once, lf_spare_key_create);
+            pthread_setspecific(lf_spare_key, &lf_spare);
+        }
+        ((LfNode*)node)->next = (uintptr_t)lf_spare.head;
+        lf_spare.head = node;
+        lf_spare.count++;
+        return;
+    }
+    mem_free_inline(node, sizeof(LfNode));
+}
+
+// Find the first node with a value >= data and its predecessor, unlinking
+// marked nodes on the way. Must be called inside a read-side section.
+static LfNode* lf_find(LfList* list, uint16_t data, LfNode** prev_out) {
+retry:;
+    LfNode* prev = list->head;
+    LfNode* curr = lf_pointer(lf_load(&prev->next));
+    while (curr != NULL) {
+        uintptr_t succ = lf_load(&curr->next);
+        if (lf_marked(succ)) {
+            // curr is deleted: unlink it; the thread that does so retires it
+            if (!lf_cas(&prev->next, (uintptr_t)curr, (uintptr_t)lf_pointer(succ))) {
+                goto retry;
+            }
+            epoch_retire(curr, lf_node_free);
+            curr = lf_pointer(succ);
+            continue;
+        }
+        if (curr->data >= data) {
+            break;
+        }
+        prev = curr;
+        curr = lf_pointer(succ);
+    }
+    *prev_out = prev;
+    return curr;
+}
+
+// Create an empty list. The memory pool must already be set up.
+bool lf_init(LfList* list) {
+    list->head = mem_alloc(sizeof(LfNode));
+    if (list->head == NULL) {
+        printf("Memory allocation for the list head failed.\n");
+        return false;
+    }
+    list->head->data = 0;
+    list->head->next = 0;
+    return true;
+}
+
+// Insert a value; false if it is already in the list or memory ran out
+bool lf_insert(LfList* list, uint16_t data) {
+    if (!epoch_enter()) {
+        return false;
+    }
+    LfNode* node = NULL;  // Allocated once the value is known to be missing
+    bool inserted = false;
+    for (;;) {
+        LfNode* prev;
+        LfNode* curr = lf_find(list, data, &prev);
+        if (curr != NULL && curr->data == data) {
+            break;
+        }
+        if (node == NULL) {
+            node = lf_node_alloc();
+            if (node == NULL) {
+                printf("Memory allocation for new node failed.\n");
+                break;
+            }
+            node->data = data;
+        }
+        __atomic_store_n(&node->next, (uintptr_t)curr, __ATOMIC_RELAXED);
+        if (lf_cas(&prev->next, (uintptr_t)curr, (uintptr_t)node)) {
+            inserted = true;
+            break;
+        }
+    }
+    epoch_exit();
+    if (!inserted && node != NULL) {
+        lf_node_free(node);  // Never published
+    }
+    return inserted;
+}
+
+// Delete a value; false if it is not in the list
+bool lf_delete(LfList* list, uint16_t data) {
+    if (!epoch_enter()) {
+        return false;
+    }
+    bool deleted = false;
+    for (;;) {
+        LfNode* prev;
+        LfNode* curr = lf_find(list, data, &prev);
+        if (curr == NULL || curr->data != data) {
+            break;
+        }
+        // Marking the node is the deletion; a failed CAS means the node
+        // changed under us, so look again
+        uintptr_t succ = lf_load(&curr->next);
+        if (lf_marked(succ) || !lf_cas(&curr->next, succ, succ | LF_MARK)) {
+            continue;
+        }
+        deleted = true;
+        if (lf_cas(&prev->next, (uintptr_t)curr, succ)) {
+            epoch_retire(curr, lf_node_free);
+        } else {
+            lf_find(list, data, &prev);  // Let a search unlink it
+        }
+        break;
+    }
+    epoch_exit();
+    return deleted;
+}
+
+// Whether a value is in the list. Never writes to the list.
+bool lf_contains(LfList* list, uint16_t data) {
+    if (!epoch_enter()) {
+        return false;
+    }
+    LfNode* curr = lf_pointer(lf_load(&list->head->next));
+    while (curr != NULL && curr->data < data) {
+        curr = lf_pointer(lf_load(&curr->next));
+    }
+    bool found = curr != NULL && curr->data == data && !lf_marked(lf_load(&curr->next));
+    epoch_exit();
+    return found;
+}
+
+// Number of values in the list; only a snapshot while other threads change it
+size_t lf_count(LfList* list) {
+    size_t count = 0;
+    if (!epoch_enter()) {
+        return 0;
+    }
+    for (LfNode* curr = lf_pointer(lf_load(&list->head->next)); curr != NULL;) {
+        uintptr_t succ = lf_load(&curr->next);
+        count += !lf_marked(succ);
+        curr = lf_pointer(succ);
+    }
+    epoch_exit();
+    return count;
+}
+
+// Free the list. No other thread may use it any more, and every thread that
+// deleted from it must have exited or called epoch_synchronize.
+void lf_destroy(LfList* list) {
+    LfNode* curr = lf_pointer(list->head->next);
+    while (curr != NULL) {
+        LfNode* next = lf_pointer(curr->next);
+        mem_free(curr);
+        curr = next;
+    }
+    mem_free(list->head);
+    list->head = NULL;
+    epoch_synchronize();
+    lf_spare_release(NULL);
+}
@@ -0,0 +1,31 @@
+#ifndef LOCKFREE_LIST_H
+#define LOCKFREE_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Node of a lock-free list. The lowest bit of next marks the node as deleted;
+// marked nodes are unlinked by whichever thread next walks past them.
+typedef struct LfNode {
+    uint16_t data;      // Data field (16-bit unsigned integer)
+    uintptr_t next;     // Next node, with the deletion mark in bit 0
+} LfNode;
+
+// Sorted set of values that any number of threads can insert into, delete
+// from and search at once (Harris's list, with the unlinking of marked nodes
+// done during searches as in Michael's version). Deleted nodes are freed
+// through epoch-based reclamation (see epoch.h), so nodes are only returned
+// to the pool once no thread can still be reading them.
+typedef struct LfList {
+    LfNode* head;       // Sentinel; head->next is the first node
+} LfList;
+
+bool lf_init(LfList* list);
+bool lf_insert(LfList* list, uint16_t data);
+bool lf_delete(LfList* list, uint16_t data);
+bool lf_contains(LfList* list, uint16_t data);
+size_t lf_count(LfList* list);
+void lf_destroy(LfList* list);
+
+#endif
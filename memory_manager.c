@@ -1,128 +1,1434 @@
+#define _GNU_SOURCE  // For sched_getcpu
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include "memory_manager.h"
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include "common_defs.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-// Structure for memory blocks in the pool
+#define POOL_MAGIC 0x324c4f4f504d454dULL  // "MEMPOOL2", set once a pool is ready
+#define NULL_OFFSET MEM_NULL_OFFSET
+#define GRANULE sizeof(size_t)  // Blocks start on multiples of this
+#define POOL_MAX_SIZE ((size_t)INT32_MAX * GRANULE)  // Block sizes and offsets are kept in granules
+#define WAIT_POLL_MS 10  // How often mem_alloc_wait rechecks a shared pool
+#define SIZE_CLASS_LIMIT (64 * 1024)  // Largest request size that is profiled and rounded
+#define NONTEMPORAL_THRESHOLD (256 * 1024)  // mem_calloc clears blocks this large around the cache
+
+// Allocator trace output, only in debug builds
+#ifdef DEBUG
+#define mm_trace(...) printf(__VA_ARGS__)
+#else
+#define mm_trace(...) ((void)0)
+#endif
+
+// Structure for memory blocks in the pool. Headers are kept in a table beside
+// the pool with one slot per 8-byte granule, so the pool holds only user data
+// and the header of a block is found directly from the block's offset. The
+// blocks of an arena tile it in address order, so the next block starts where
+// a block ends and needs no link; with sizes counted in granules a slot takes
+// 8 bytes, as much as the granule it describes. Slots that do not start a
+// block are kept zeroed, so a size of 0 marks pointers into the middle of one.
 typedef struct Block {
-    size_t size;        // Size of the block (usable memory)
-    bool is_free;       // Block status (true if free, false if allocated)
-    struct Block* next; // Pointer to the next block in the memory pool
+    uint32_t size : 31;     // Size of the block (usable memory) in granules, 0 if no block starts here
+    uint32_t is_free : 1;   // Block status (1 if free, 0 if allocated)
+    union {
+        uint32_t dirty;     // Free: leading granules that may be non-zero; the rest is known to be zero
+        uint32_t handle;    // Allocated: handle of a movable block (see mem_halloc), 0 if pinned
+    };
 } Block;
 
+// Entry in the handle table. Handles stay valid while mem_compact moves blocks.
+typedef struct HandleEntry {
+    uint32_t offset;        // Offset of the block in granules, or the next free entry while unused
+    uint32_t locks : 31;    // Outstanding mem_hlock calls; locked blocks are never moved
+    uint32_t in_use : 1;    // Entry is handed out
+} HandleEntry;
+
+// A sub-heap: a contiguous part of the pool with its own block list and lock
+typedef struct Arena {
+    pthread_mutex_t lock;  // Guards the arena's block list (process-shared in shared mode)
+    size_t first;          // Offset of the arena's first block
+} Arena;
+
+// Control header at the start of every pool mapping, followed by the pool itself
+typedef struct PoolHeader {
+    uint64_t magic;        // POOL_MAGIC once the creator has finished initializing
+    size_t size;           // Total size of the memory pool
+    size_t mapping_size;   // Size of the whole mapping, this header included
+    void* base;            // Address of the mapping when the pool was last snapshotted
+    size_t root;           // Offset of the application's root object (see mem_set_root)
+    int arena_mode;        // MemArenaMode the pool was created with
+    size_t arena_count;    // Number of arenas the pool is split into
+    size_t arena_span;     // Bytes of pool each arena covers
+    size_t table_offset;   // Offset of the block header table from the start of the mapping
+    size_t handle_offset;  // Offset of the handle table from the start of the mapping
+    size_t handle_next;    // Number of handle entries ever handed out
+    size_t handle_free;    // First free handle entry (a handle value), 0 if none
+    size_t used;           // Bytes held by allocated blocks
+    pthread_mutex_t handle_lock;  // Guards handle_next, handle_free and the free entries
+    Arena arenas[MEM_MAX_ARENAS];
+} PoolHeader;
+
+// Keep the pool itself aligned regardless of the size of the lock
+#define POOL_HEADER_SIZE ((sizeof(PoolHeader) + 15) & ~(size_t)15)
+
+PoolHeader* pool_header = NULL; // Pointer to the start of the mapping
 void* memory_pool = NULL;       // Pointer to the start of the memory pool
 size_t memory_pool_size = 0;    // Total size of the memory pool
-Block* free_list = NULL;        // Linked list of free blocks in the memory pool
+Block* block_table = NULL;      // Block headers, indexed by block offset / GRANULE
+HandleEntry* handle_table = NULL; // Handle entries, indexed by handle - 1
+
+static bool pool_is_shared = false;          // Pool lives in a named shared-memory object
+static bool pool_is_owner = false;           // This process created the shared object
+static char pool_name[NAME_MAX + 1];         // Name of the shared object
+static bool pool_is_restored = false;        // Pool is a private mapping of a snapshot file
+static ptrdiff_t pool_relocation = 0;        // How far a restored pool moved from its saved base
+static size_t mmap_threshold = 0;            // Requests this large bypass the pool, 0 = never
+static unsigned next_thread_arena = 0;       // Round-robin source for per-thread arenas
+static __thread int thread_arena = -1;       // This thread's arena in per-thread mode
+
+// Memory pressure: callers parked in mem_alloc_wait and the soft limit callbacks.
+// Both are per process; a shared pool's frees in other processes are polled.
+typedef struct PressureCallback {
+    MemPressureCallback callback;
+    void* context;
+} PressureCallback;
+
+static pthread_mutex_t pressure_lock = PTHREAD_MUTEX_INITIALIZER;  // Guards everything below
+static pthread_cond_t space_freed = PTHREAD_COND_INITIALIZER;     // Signalled when waiters may fit
+static unsigned free_generation = 0;         // Bumped by every free that found waiters
+static unsigned space_waiters = 0;           // Callers inside mem_alloc_wait (atomic)
+static PressureCallback pressure_callbacks[MEM_MAX_PRESSURE_CALLBACKS];
+static size_t soft_limit = 0;                // Used bytes that trigger the callbacks, 0 = never (atomic)
+static bool pressure_armed = true;           // Cleared when the callbacks fire, set below the limit (atomic)
+
+// Size classes: requests are rounded up to the next class so freed blocks
+// fit later requests exactly. The table is per process and outlives pools.
+static size_t size_classes[MEM_MAX_SIZE_CLASSES];  // Ascending class sizes (atomic)
+static size_t size_class_count = 0;          // Classes in use, 0 = no rounding (atomic)
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;  // Serializes table updates
+static size_t profile_histogram[SIZE_CLASS_LIMIT / GRANULE];     // Requests seen, by aligned size
+static size_t profile_remaining = 0;         // Samples left in the warm-up window (atomic)
+static size_t profile_classes = 0;           // Number of classes to derive from the profile
+
+// Thread caches behind mem_alloc_inline and mem_free_inline (see memory_manager.h)
+__thread MemTcache mem_tcache;
+unsigned mem_pool_generation = 1;            // Bumped whenever the pool changes
+static pthread_key_t tcache_key;             // Flushes a thread's cache when it exits
+static pthread_once_t tcache_key_once = PTHREAD_ONCE_INIT;
+
+// Allocation served directly by mmap, outside the pool
+typedef struct HugeBlock {
+    void* data;         // Start of the mapping, NULL for an empty slot
+    size_t size;        // Size the caller asked for
+    size_t length;      // Length of the mapping
+} HugeBlock;
+
+// Side table of huge blocks: open addressing on the (page aligned) address.
+// Huge blocks are private to the process, so the table is too.
+static HugeBlock* huge_table = NULL;
+static size_t huge_capacity = 0;             // Slots in huge_table, a power of two
+static size_t huge_count = 0;                // Slots in use
+static pthread_mutex_t huge_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Translate between block offsets, block headers and block data in this process
+static inline Block* block_at(size_t offset) {
+    return offset == NULL_OFFSET ? NULL : &block_table[offset / GRANULE];
+}
+
+static inline size_t block_offset(const Block* block) {
+    return (size_t)(block - block_table) * GRANULE;
+}
+
+static inline void* block_data(const Block* block) {
+    return (char*)memory_pool + block_offset(block);
+}
+
+// Usable bytes of a block
+static inline size_t block_bytes(const Block* block) {
+    return (size_t)block->size * GRANULE;
+}
+
+// The block after a block in its arena, or NULL for the arena's last block
+static inline Block* block_next(const Block* block) {
+    size_t end = block_offset(block) + block_bytes(block);
+    return end % pool_header->arena_span == 0 ? NULL : block_at(end);
+}
+
+// Usable bytes in each arena. The pool is split evenly, keeping every arena
+// (and so every block list) a whole number of granules.
+static size_t arena_size(size_t size, size_t arena_count) {
+    return (size / arena_count) & ~(GRANULE - 1);
+}
+
+// Offset of the block header table, which follows the pool in the mapping
+static size_t pool_table_offset(size_t size, size_t arena_count) {
+    size_t pool_bytes = arena_count * arena_size(size, arena_count);
+    return POOL_HEADER_SIZE + ((pool_bytes + 15) & ~(size_t)15);
+}
+
+// Number of block header (and handle) slots: one per granule, the worst
+// case of nothing but minimal blocks
+static size_t pool_slots(size_t size, size_t arena_count) {
+    size_t pool_bytes = arena_count * arena_size(size, arena_count);
+    return (pool_bytes + GRANULE - 1) / GRANULE + 1;
+}
+
+// Offset of the handle table, which follows the block header table
+static size_t pool_handle_offset(size_t size, size_t arena_count) {
+    size_t table_bytes = pool_slots(size, arena_count) * sizeof(Block);
+    return pool_table_offset(size, arena_count) + ((table_bytes + 15) & ~(size_t)15);
+}
+
+/**
+ * Computes the size of the mapping backing a pool of the given size: the
+ * pool itself plus 8 bytes of block header and 8 bytes of handle entry per
+ * granule, about three times the pool. Shared pools size their object to it.
+ *
+ * Both tables are sized for the worst case, but only slots that are used are
+ * ever written, and pages that are never touched are never backed by
+ * physical memory.
+ */
+static size_t pool_mapping_size(size_t size, size_t arena_count) {
+    size_t mapping_size = pool_handle_offset(size, arena_count) +
+                          pool_slots(size, arena_count) * sizeof(HandleEntry);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (mapping_size + page - 1) & ~(page - 1);
+}
+
+/**
+ * Points the global pool state at a mapping that has already been set up.
+ */
+static void pool_attach(PoolHeader* header) {
+    __atomic_add_fetch(&mem_pool_generation, 1, __ATOMIC_RELEASE);  // Drop every thread cache
+    pool_header = header;
+    memory_pool = (char*)header + POOL_HEADER_SIZE;
+    memory_pool_size = header->size;
+    block_table = (Block*)((char*)header + header->table_offset);
+    handle_table = (HandleEntry*)((char*)header + header->handle_offset);
+}
+
+// (Re)initializes the locks of every arena in the pool
+static bool pool_init_locks(PoolHeader* header, bool shared) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if (shared) {
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    }
+    bool ok = pthread_mutex_init(&header->handle_lock, &attr) == 0;
+    for (size_t k = 0; k < header->arena_count && ok; k++) {
+        ok = pthread_mutex_init(&header->arenas[k].lock, &attr) == 0;
+    }
+    pthread_mutexattr_destroy(&attr);
+    if (!ok) {
+        printf("Memory pool lock initialization failed\n");
+    }
+    return ok;
+}
+
+/**
+ * Initializes the control header and the first block of every arena in a
+ * fresh mapping.
+ *
+ * @param header: Start of the mapping.
+ * @param size: The total size of the memory pool.
+ * @param mode: How allocations pick an arena.
+ * @param arena_count: Number of arenas to split the pool into.
+ * @param mapping_size: The size of the whole mapping.
+ * @param shared: True if the locks must work across processes.
+ */
+static bool pool_setup(PoolHeader* header, size_t size, MemArenaMode mode, size_t arena_count,
+                       size_t mapping_size, bool shared) {
+    header->size = size;
+    header->mapping_size = mapping_size;
+    header->base = header;
+    header->root = NULL_OFFSET;
+    header->arena_mode = mode;
+    header->arena_count = arena_count;
+    header->arena_span = arena_size(size, arena_count);
+    header->table_offset = pool_table_offset(size, arena_count);
+    header->handle_offset = pool_handle_offset(size, arena_count);
+    header->handle_next = 0;
+    header->handle_free = 0;
+    header->used = 0;
+    if (!pool_init_locks(header, shared)) {
+        return false;
+    }
+
+    // Initialize the first block of each arena
+    for (size_t k = 0; k < arena_count; k++) {
+        Arena* arena = &header->arenas[k];
+        arena->first = k * header->arena_span;
+        Block* first = (Block*)((char*)header + header->table_offset) + arena->first / GRANULE;
+        first->size = (uint32_t)(arena_size(size, arena_count) / GRANULE);
+        first->is_free = true;
+        first->dirty = 0;  // Fresh mappings are zero-filled
+    }
+
+    // Publish the pool; processes attaching by name wait for this
+    __atomic_store_n(&header->magic, POOL_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void lock_mutex(pthread_mutex_t* lock) {
+    int rc = pthread_mutex_lock(lock);
+    if (rc == EOWNERDEAD) {
+        // A process died while holding the lock. Every block list update is a
+        // handful of stores, so accept the list as is rather than wedging
+        // every other process on the pool.
+        printf("Memory pool lock owner died, recovering\n");
+        pthread_mutex_consistent(lock);
+    }
+}
+
+static void pool_lock(Arena* arena) {
+    lock_mutex(&arena->lock);
+}
+
+static void pool_unlock(Arena* arena) {
+    pthread_mutex_unlock(&arena->lock);
+}
+
+// Arena a block belongs to, from the block's offset
+static inline Arena* arena_of(const Block* block) {
+    return &pool_header->arenas[block_offset(block) / pool_header->arena_span];
+}
+
+// Number of bytes of the mapping that belong to arenas
+static inline size_t pool_bytes(void) {
+    return pool_header->arena_count * pool_header->arena_span;
+}
+
+/**
+ * Looks up the header of an allocated block from the pointer handed out for it.
+ *
+ * @return: The header, or NULL for pointers that were never handed out by
+ *          this pool, including pointers into the middle of a block.
+ */
+static Block* block_of(const void* ptr) {
+    if (!ptr || !pool_header || (const char*)ptr < (const char*)memory_pool) {
+        return NULL;
+    }
+    size_t offset = (size_t)((const char*)ptr - (const char*)memory_pool);
+    if (offset >= pool_bytes() || offset % GRANULE != 0 || block_at(offset)->size == 0) {
+        return NULL;
+    }
+    return block_at(offset);
+}
+
+/**
+ * Picks the arena a new allocation should try first.
+ *
+ * Per-CPU mode uses sched_getcpu(), which glibc serves from the restartable
+ * sequences area without a system call, so threads running on different CPUs
+ * take different locks however many threads there are. A thread migrating
+ * between the lookup and the lock is harmless: it only costs contention.
+ */
+static size_t arena_pick(void) {
+    size_t count = pool_header->arena_count;
+    if (count == 1) {
+        return 0;
+    }
+    if (pool_header->arena_mode == MEM_ARENA_PER_CPU) {
+        int cpu = sched_getcpu();
+        return cpu < 0 ? 0 : (size_t)cpu % count;
+    }
+    if (thread_arena < 0) {
+        thread_arena = (int)(__atomic_fetch_add(&next_thread_arena, 1, __ATOMIC_RELAXED) % MEM_MAX_ARENAS);
+    }
+    return (size_t)thread_arena % count;
+}
 
 /**
  * Initializes the memory pool.
- * 
+ *
  * @param size: The total size of the memory pool to be initialized.
- * 
+ *
  * This function allocates memory for the memory pool and sets up the first block
  * in the free list. If memory allocation fails, the function returns without
  * further action.
  */
 void mem_init(size_t size) {
-    memory_pool = malloc(size);  // Allocate memory for the pool
-    if (!memory_pool) {
+    mem_init_arenas(size, MEM_ARENA_SINGLE, 1);
+}
+
+/**
+ * Initializes a memory pool split into several arenas (sub-heaps), each with
+ * its own block list and lock.
+ *
+ * @param size: The total size of the memory pool, divided evenly between arenas.
+ * @param mode: MEM_ARENA_PER_CPU picks the arena of the CPU the caller runs on,
+ *              MEM_ARENA_PER_THREAD gives every thread an arena of its own
+ *              (threads beyond the arena count share), MEM_ARENA_SINGLE
+ *              behaves like mem_init().
+ * @param arena_count: Number of arenas, at most MEM_MAX_ARENAS. 0 picks one
+ *              per configured CPU for per-CPU mode and MEM_MAX_ARENAS otherwise.
+ *
+ * @return: true on success, false if the pool could not be mapped.
+ *
+ * An allocation that does not fit in its preferred arena is tried in the
+ * others, so no memory is stranded; mem_free returns a block to the arena
+ * it came from.
+ */
+bool mem_init_arenas(size_t size, MemArenaMode mode, size_t arena_count) {
+    if (mode == MEM_ARENA_SINGLE) {
+        arena_count = 1;
+    } else if (arena_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        arena_count = mode == MEM_ARENA_PER_CPU && cpus > 0 ? (size_t)cpus : MEM_MAX_ARENAS;
+    }
+    if (arena_count > MEM_MAX_ARENAS) {
+        arena_count = MEM_MAX_ARENAS;
+    }
+    if (size > POOL_MAX_SIZE) {
+        printf("Memory pool too large\n");
+        return false;
+    }
+
+    size_t mapping_size = pool_mapping_size(size, arena_count);
+    void* base = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        printf("Memory pool allocation failed\n");
+        return false;
+    }
+
+    if (!pool_setup((PoolHeader*)base, size, mode, arena_count, mapping_size, false)) {
+        munmap(base, mapping_size);
+        return false;
+    }
+
+    pool_is_shared = false;
+    pool_is_owner = false;
+    pool_is_restored = false;
+    pool_relocation = 0;
+    pool_attach((PoolHeader*)base);
+    return true;
+}
+
+/**
+ * Creates or attaches to a memory pool in a named shared-memory object.
+ *
+ * @param name: POSIX shared-memory name, e.g. "/ingest_pool".
+ * @param size: The total size of the memory pool if it has to be created.
+ *              Ignored when attaching to an existing pool.
+ *
+ * @return: true on success, false if the object could not be created or mapped.
+ *
+ * The first process to call this creates and initializes the pool; later
+ * callers map the same pool, usually at a different address. Internal block
+ * links are offsets, so every process can allocate and free in the pool, and
+ * blocks can be handed between processes with mem_offset()/mem_from_offset().
+ * The creator removes the name again in mem_deinit().
+ */
+bool mem_init_shared(const char* name, size_t size) {
+    if (strlen(name) > NAME_MAX) {
+        printf("Shared memory name too long\n");
+        return false;
+    }
+    if (size > POOL_MAX_SIZE) {
+        printf("Memory pool too large\n");
+        return false;
+    }
+
+    size_t mapping_size = pool_mapping_size(size, 1);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    bool owner = fd >= 0;
+
+    if (owner) {
+        if (ftruncate(fd, (off_t)mapping_size) != 0) {
+            printf("Sizing shared memory pool failed: %s\n", strerror(errno));
+            close(fd);
+            shm_unlink(name);
+            return false;
+        }
+    } else {
+        if (errno != EEXIST || (fd = shm_open(name, O_RDWR, 0600)) < 0) {
+            printf("Opening shared memory pool failed: %s\n", strerror(errno));
+            return false;
+        }
+
+        // The creator may not have sized the object yet
+        struct stat st;
+        int tries = 0;
+        while (fstat(fd, &st) == 0 && st.st_size == 0 && tries++ < 1000) {
+            usleep(1000);
+        }
+        if (st.st_size < (off_t)POOL_HEADER_SIZE) {
+            printf("Shared memory pool was never initialized\n");
+            close(fd);
+            return false;
+        }
+        mapping_size = (size_t)st.st_size;
+    }
+
+    void* base = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
         printf("Memory pool allocation failed\n");
+        if (owner) {
+            shm_unlink(name);
+        }
+        return false;
+    }
+
+    PoolHeader* header = (PoolHeader*)base;
+    if (owner) {
+        if (!pool_setup(header, size, MEM_ARENA_SINGLE, 1, mapping_size, true)) {
+            munmap(base, mapping_size);
+            shm_unlink(name);
+            return false;
+        }
+    } else {
+        int tries = 0;
+        while (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != POOL_MAGIC && tries++ < 1000) {
+            usleep(1000);
+        }
+        if (header->magic != POOL_MAGIC) {
+            printf("Shared memory pool was never initialized\n");
+            munmap(base, mapping_size);
+            return false;
+        }
+    }
+
+    pool_is_shared = true;
+    pool_is_owner = owner;
+    pool_is_restored = false;
+    pool_relocation = 0;
+    strcpy(pool_name, name);
+    pool_attach(header);
+    return true;
+}
+
+static void timespec_add_ms(struct timespec* ts, long ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static int timespec_cmp(const struct timespec* a, const struct timespec* b) {
+    if (a->tv_sec != b->tv_sec) {
+        return a->tv_sec < b->tv_sec ? -1 : 1;
+    }
+    return a->tv_nsec < b->tv_nsec ? -1 : a->tv_nsec > b->tv_nsec;
+}
+
+// Merges a free block into the free block in front of it
+static void block_merge(Block* current, Block* next) {
+    current->dirty = next->dirty ? current->size + next->dirty : current->dirty;
+    current->size += next->size;
+    *next = (Block){0};  // No block starts here any more
+}
+
+/**
+ * First-fit allocation from a single arena.
+ *
+ * @param arena: The arena to allocate from.
+ * @param requested_size: The aligned size of memory to be allocated.
+ * @param dirty: If not NULL, set to how many leading bytes of the block may
+ *               be non-zero.
+ *
+ * @return: Pointer to the allocated memory, or NULL if the arena has no room.
+ */
+static void* arena_alloc(Arena* arena, size_t requested_size, size_t* dirty) {
+    if (requested_size > pool_header->arena_span) {
+        return NULL;
+    }
+    pool_lock(arena);
+    uint32_t granules = (uint32_t)(requested_size / GRANULE);
+    Block* current = block_at(arena->first);
+    while (current != NULL) {
+        mm_trace("Current block size: %zu, is_free: %d\n", block_bytes(current), current->is_free);
+
+        if (current->is_free && current->size >= granules) {
+            // Calculate remaining size after allocation
+            uint32_t remaining = current->size - granules;
+            uint32_t block_dirty = current->dirty;
+
+            if (remaining > 0) {
+                // Create a new block from the remaining memory; its header
+                // is in the block table, so a single granule is enough
+                Block* new_block = block_at(block_offset(current) + requested_size);
+                new_block->size = remaining;
+                new_block->is_free = true;
+                new_block->dirty = block_dirty > granules ? block_dirty - granules : 0;
+
+                // Update the current block's size
+                current->size = granules;
+                block_dirty = block_dirty < granules ? block_dirty : granules;
+            }
+
+            current->is_free = false;
+            current->handle = 0;
+            __atomic_add_fetch(&pool_header->used, block_bytes(current), __ATOMIC_RELAXED);
+            if (dirty) {
+                *dirty = (size_t)block_dirty * GRANULE;
+            }
+            pool_unlock(arena);
+            mm_trace("Allocated block of size: %zu\n", block_bytes(current));
+            return block_data(current);
+        }
+        current = block_next(current);
+    }
+    pool_unlock(arena);
+    return NULL;
+}
+
+// Home slot of an address in the huge block table
+static size_t huge_slot(const void* data) {
+    return (size_t)(((uintptr_t)data >> 12) * 0x9e3779b97f4a7c15ULL) & (huge_capacity - 1);
+}
+
+// Finds the table slot of a huge block. The caller must hold huge_lock.
+static HugeBlock* huge_find(const void* data) {
+    if (huge_count == 0) {
+        return NULL;
+    }
+    for (size_t i = huge_slot(data);; i = (i + 1) & (huge_capacity - 1)) {
+        if (huge_table[i].data == data) {
+            return &huge_table[i];
+        }
+        if (huge_table[i].data == NULL) {
+            return NULL;
+        }
+    }
+}
+
+// Adds a huge block to the table, growing it when it is half full.
+// The caller must hold huge_lock.
+static bool huge_insert(HugeBlock entry) {
+    if (2 * (huge_count + 1) > huge_capacity) {
+        size_t old_capacity = huge_capacity;
+        HugeBlock* old_table = huge_table;
+        size_t new_capacity = old_capacity ? 2 * old_capacity : 16;
+        HugeBlock* new_table = calloc(new_capacity, sizeof(HugeBlock));
+        if (!new_table) {
+            return false;
+        }
+        huge_table = new_table;
+        huge_capacity = new_capacity;
+        huge_count = 0;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_table[i].data) {
+                huge_insert(old_table[i]);
+            }
+        }
+        free(old_table);
+    }
+    size_t i = huge_slot(entry.data);
+    while (huge_table[i].data != NULL) {
+        i = (i + 1) & (huge_capacity - 1);
+    }
+    huge_table[i] = entry;
+    huge_count++;
+    return true;
+}
+
+// Removes a slot from the table, shifting later entries of the same probe
+// run back so lookups never stop early. The caller must hold huge_lock.
+static void huge_remove(HugeBlock* slot) {
+    size_t hole = (size_t)(slot - huge_table);
+    size_t i = hole;
+    huge_table[hole].data = NULL;
+    huge_count--;
+    for (;;) {
+        i = (i + 1) & (huge_capacity - 1);
+        if (huge_table[i].data == NULL) {
+            return;
+        }
+        size_t home = huge_slot(huge_table[i].data);
+        // Move the entry if its home is not between the hole and its slot
+        if (((i - home) & (huge_capacity - 1)) >= ((i - hole) & (huge_capacity - 1))) {
+            huge_table[hole] = huge_table[i];
+            huge_table[i].data = NULL;
+            hole = i;
+        }
+    }
+}
+
+static size_t huge_length(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+// Serves a request directly from a fresh mapping
+static void* huge_alloc(size_t size) {
+    size_t length = huge_length(size);
+    void* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    pthread_mutex_lock(&huge_lock);
+    bool ok = huge_insert((HugeBlock){data, size, length});
+    pthread_mutex_unlock(&huge_lock);
+    if (!ok) {
+        munmap(data, length);
+        return NULL;
+    }
+    mm_trace("Mapped huge block of size: %zu\n", size);
+    return data;
+}
+
+// Releases a huge block; returns false if ptr is not one
+static bool huge_free(void* ptr) {
+    pthread_mutex_lock(&huge_lock);
+    HugeBlock* slot = huge_find(ptr);
+    if (!slot) {
+        pthread_mutex_unlock(&huge_lock);
+        return false;
+    }
+    size_t length = slot->length;
+    huge_remove(slot);
+    pthread_mutex_unlock(&huge_lock);
+    munmap(ptr, length);
+    return true;
+}
+
+// Unmaps every huge block, when the pool goes away
+static void huge_free_all(void) {
+    pthread_mutex_lock(&huge_lock);
+    for (size_t i = 0; i < huge_capacity; i++) {
+        if (huge_table[i].data) {
+            munmap(huge_table[i].data, huge_table[i].length);
+        }
+    }
+    free(huge_table);
+    huge_table = NULL;
+    huge_capacity = 0;
+    huge_count = 0;
+    pthread_mutex_unlock(&huge_lock);
+}
+
+/**
+ * Sets the size from which mem_alloc serves requests with their own mmap
+ * instead of from the pool.
+ *
+ * @param threshold: Minimum request size for the direct path, or 0 to serve
+ *                   everything from the pool (the default).
+ *
+ * Huge blocks never fragment the pool or compete with small blocks for it,
+ * and mem_resize grows them with mremap instead of copying. They do not
+ * count against the pool size, are private to the process (shared pools
+ * never use them) and are not part of snapshots.
+ */
+void mem_set_mmap_threshold(size_t threshold) {
+    mmap_threshold = threshold;
+}
+
+// Runs the pressure callbacks outside every allocator lock, so they can free
+static void pressure_notify(void) {
+    PressureCallback callbacks[MEM_MAX_PRESSURE_CALLBACKS];
+    pthread_mutex_lock(&pressure_lock);
+    memcpy(callbacks, pressure_callbacks, sizeof(callbacks));
+    pthread_mutex_unlock(&pressure_lock);
+    size_t limit = __atomic_load_n(&soft_limit, __ATOMIC_RELAXED);
+
+    size_t used = pool_header ? __atomic_load_n(&pool_header->used, __ATOMIC_RELAXED) : 0;
+    for (size_t i = 0; i < MEM_MAX_PRESSURE_CALLBACKS; i++) {
+        if (callbacks[i].callback) {
+            callbacks[i].callback(used, limit, callbacks[i].context);
+        }
+    }
+}
+
+// Fires the callbacks once each time usage climbs past the soft limit. Blocks
+// parked in the calling thread's cache count as used, so they go back to the
+// pool first, and the callbacks only run if that was not enough.
+static void pressure_check(void) {
+    size_t limit = __atomic_load_n(&soft_limit, __ATOMIC_RELAXED);
+    if (limit == 0 || __atomic_load_n(&pool_header->used, __ATOMIC_RELAXED) <= limit ||
+        !__atomic_load_n(&pressure_armed, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    mem_tcache_flush();
+    if (__atomic_load_n(&pool_header->used, __ATOMIC_RELAXED) <= limit) {
+        return;
+    }
+    if (__atomic_exchange_n(&pressure_armed, false, __ATOMIC_ACQ_REL)) {
+        pressure_notify();
+    }
+}
+
+// After a free: re-arm the soft limit and wake callers waiting for room
+static void pool_released(void) {
+    size_t limit = __atomic_load_n(&soft_limit, __ATOMIC_RELAXED);
+    if (limit != 0 && !__atomic_load_n(&pressure_armed, __ATOMIC_RELAXED) &&
+        __atomic_load_n(&pool_header->used, __ATOMIC_RELAXED) <= limit) {
+        __atomic_store_n(&pressure_armed, true, __ATOMIC_RELEASE);
+    }
+    if (__atomic_load_n(&space_waiters, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pressure_lock);
+        free_generation++;
+        pthread_cond_broadcast(&space_freed);
+        pthread_mutex_unlock(&pressure_lock);
+    }
+}
+
+// Smallest class that holds an aligned request, or the request itself
+static size_t size_class_round(size_t size) {
+    size_t count = __atomic_load_n(&size_class_count, __ATOMIC_ACQUIRE);
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (__atomic_load_n(&size_classes[mid], __ATOMIC_RELAXED) < size) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    // A table being replaced can be read torn; never hand out less than asked
+    size_t rounded = lo < count ? __atomic_load_n(&size_classes[lo], __ATOMIC_RELAXED) : size;
+    return rounded > size ? rounded : size;
+}
+
+// Installs a validated class table
+static void size_class_store(const size_t* classes, size_t count) {
+    __atomic_store_n(&size_class_count, 0, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < count; i++) {
+        __atomic_store_n(&size_classes[i], classes[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&size_class_count, count, __ATOMIC_RELEASE);
+}
+
+// Prefix sums over the profiled sizes, used by size_class_cost
+typedef struct ProfileSums {
+    size_t* size;      // Distinct sizes seen, ascending
+    double* count;     // count[j]: requests with one of the first j sizes
+    double* bytes;     // bytes[j]: bytes requested with one of the first j sizes
+} ProfileSums;
+
+// Wasted bytes when sizes i..j-1 all round up to size j-1
+static double size_class_cost(const ProfileSums* sums, size_t i, size_t j) {
+    return (double)sums->size[j - 1] * (sums->count[j] - sums->count[i]) - (sums->bytes[j] - sums->bytes[i]);
+}
+
+// Fills cost[j] for j in [lo, hi] with the best split of the first j sizes,
+// whose last class starts between from and to. The optimal split point never
+// moves left as j grows, which lets each level be solved by divide and conquer.
+static void size_class_level(const ProfileSums* sums, const double* prev, double* cost, size_t* split,
+                             size_t lo, size_t hi, size_t from, size_t to) {
+    if (lo > hi) {
+        return;
+    }
+    size_t mid = (lo + hi) / 2;
+    size_t best = from;
+    double best_cost = -1;
+    for (size_t i = from; i <= to && i < mid; i++) {
+        double c = prev[i] + size_class_cost(sums, i, mid);
+        if (best_cost < 0 || c < best_cost) {
+            best_cost = c;
+            best = i;
+        }
+    }
+    cost[mid] = best_cost;
+    split[mid] = best;
+    if (mid > lo) {
+        size_class_level(sums, prev, cost, split, lo, mid - 1, from, best);
+    }
+    size_class_level(sums, prev, cost, split, mid + 1, hi, best, to);
+}
+
+/**
+ * Derives the class table that wastes the fewest bytes on the profiled
+ * requests, and installs it. Called with profile_lock held.
+ */
+static void size_class_derive(size_t max_classes) {
+    size_t buckets = SIZE_CLASS_LIMIT / GRANULE;
+    size_t n = 0;
+    for (size_t b = 0; b < buckets; b++) {
+        n += __atomic_load_n(&profile_histogram[b], __ATOMIC_RELAXED) != 0;
+    }
+    if (n == 0) {
+        return;
+    }
+
+    ProfileSums sums;
+    sums.size = malloc(n * sizeof(size_t));
+    sums.count = malloc((n + 1) * sizeof(double));
+    sums.bytes = malloc((n + 1) * sizeof(double));
+    double* prev = malloc((n + 1) * sizeof(double));
+    double* cost = malloc((n + 1) * sizeof(double));
+    size_t* split = malloc((size_t)max_classes * (n + 1) * sizeof(size_t));
+    if (!sums.size || !sums.count || !sums.bytes || !prev || !cost || !split) {
+        printf("Not enough memory to derive size classes\n");
+        goto out;
+    }
+
+    sums.count[0] = sums.bytes[0] = 0;
+    for (size_t b = 0, j = 0; b < buckets; b++) {
+        size_t seen = __atomic_exchange_n(&profile_histogram[b], 0, __ATOMIC_RELAXED);
+        if (seen != 0 && j < n) {
+            sums.size[j] = (b + 1) * GRANULE;
+            sums.count[j + 1] = sums.count[j] + seen;
+            sums.bytes[j + 1] = sums.bytes[j] + (double)seen * sums.size[j];
+            j++;
+        }
+    }
+
+    // cost[j] with k classes: least waste covering the first j sizes
+    size_t classes = max_classes < n ? max_classes : n;
+    prev[0] = 0;
+    for (size_t j = 1; j <= n; j++) {
+        prev[j] = size_class_cost(&sums, 0, j);
+        split[j] = 0;
+    }
+    for (size_t k = 1; k < classes; k++) {
+        cost[0] = 0;
+        size_class_level(&sums, prev, cost, split + k * (n + 1), 1, n, 0, n - 1);
+        memcpy(prev, cost, (n + 1) * sizeof(double));
+    }
+
+    // Walk the splits back from the largest size
+    size_t table[MEM_MAX_SIZE_CLASSES];
+    size_t end = n;
+    size_t first = classes;
+    while (first > 0 && end > 0) {
+        first--;
+        table[first] = sums.size[end - 1];
+        end = split[first * (n + 1) + end];
+    }
+    size_class_store(table + first, classes - first);
+
+out:
+    free(sums.size);
+    free(sums.count);
+    free(sums.bytes);
+    free(prev);
+    free(cost);
+    free(split);
+}
+
+// Records one request during the warm-up window
+static void size_class_sample(size_t size) {
+    if (size > SIZE_CLASS_LIMIT) {
         return;
     }
-    
-    memory_pool_size = size;
-    
-    // Initialize the first block
-    free_list = (Block*)memory_pool;
-    free_list->size = size;  // Block size minus header size
-    free_list->is_free = true;
-    free_list->next = NULL;
+    size_t remaining = __atomic_load_n(&profile_remaining, __ATOMIC_RELAXED);
+    do {
+        if (remaining == 0) {
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&profile_remaining, &remaining, remaining - 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    __atomic_add_fetch(&profile_histogram[size / GRANULE - 1], 1, __ATOMIC_RELAXED);
+    if (remaining == 1) {
+        pthread_mutex_lock(&profile_lock);
+        size_class_derive(profile_classes);
+        pthread_mutex_unlock(&profile_lock);
+    }
+}
+
+/**
+ * Starts profiling request sizes.
+ *
+ * @param samples: Number of requests (of at most 64 KiB) to observe.
+ * @param class_count: Number of size classes to derive, at most
+ *                     MEM_MAX_SIZE_CLASSES.
+ *
+ * @return: true if profiling started.
+ *
+ * Once the window is full, the table that minimizes internal fragmentation
+ * for the observed sizes replaces the current one and applies to every later
+ * allocation. Requests made while profiling use the current table.
+ */
+bool mem_profile_sizes(size_t samples, size_t class_count) {
+    if (samples == 0 || class_count == 0 || class_count > MEM_MAX_SIZE_CLASSES) {
+        printf("Invalid size class profile parameters\n");
+        return false;
+    }
+    pthread_mutex_lock(&profile_lock);
+    memset(profile_histogram, 0, sizeof(profile_histogram));
+    profile_classes = class_count;
+    __atomic_store_n(&profile_remaining, samples, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&profile_lock);
+    return true;
+}
+
+/**
+ * Replaces the size class table.
+ *
+ * @param classes: Class sizes in strictly ascending order, each a multiple of
+ *                 8 and at most 64 KiB.
+ * @param count: Number of classes; 0 turns rounding off.
+ *
+ * @return: true if the table was valid and installed.
+ *
+ * Set the table before mem_init to start a pool with a tuned profile.
+ */
+bool mem_set_size_classes(const size_t* classes, size_t count) {
+    if (count > MEM_MAX_SIZE_CLASSES || (count > 0 && !classes)) {
+        printf("Invalid size class table\n");
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (classes[i] == 0 || classes[i] % GRANULE != 0 || classes[i] > SIZE_CLASS_LIMIT ||
+            (i > 0 && classes[i] <= classes[i - 1])) {
+            printf("Invalid size class table\n");
+            return false;
+        }
+    }
+    pthread_mutex_lock(&profile_lock);
+    size_class_store(classes, count);
+    pthread_mutex_unlock(&profile_lock);
+    return true;
+}
+
+/**
+ * Copies out the current size class table.
+ *
+ * @param classes: Receives up to max class sizes, ascending.
+ * @param max: Capacity of classes.
+ *
+ * @return: The number of classes in the table.
+ */
+size_t mem_get_size_classes(size_t* classes, size_t max) {
+    pthread_mutex_lock(&profile_lock);
+    size_t count = size_class_count;
+    for (size_t i = 0; i < count && i < max; i++) {
+        classes[i] = size_classes[i];
+    }
+    pthread_mutex_unlock(&profile_lock);
+    return count;
+}
+
+/**
+ * Writes the size class table to a text file, one class size per line.
+ *
+ * @return: true on success.
+ */
+bool mem_save_size_classes(const char* path) {
+    size_t classes[MEM_MAX_SIZE_CLASSES];
+    size_t count = mem_get_size_classes(classes, MEM_MAX_SIZE_CLASSES);
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Cannot open size class file %s\n", path);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        fprintf(file, "%zu\n", classes[i]);
+    }
+    return fclose(file) == 0;
+}
+
+/**
+ * Loads a size class table written by mem_save_size_classes.
+ *
+ * @return: true if the file held a valid table, which is now installed.
+ */
+bool mem_load_size_classes(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("Cannot open size class file %s\n", path);
+        return false;
+    }
+    size_t classes[MEM_MAX_SIZE_CLASSES];
+    size_t count = 0;
+    size_t value;
+    bool valid = true;
+    while (fscanf(file, "%zu", &value) == 1) {
+        if (count == MEM_MAX_SIZE_CLASSES) {
+            valid = false;
+            break;
+        }
+        classes[count++] = value;
+    }
+    valid = valid && feof(file);
+    fclose(file);
+    if (!valid) {
+        printf("Malformed size class file %s\n", path);
+        return false;
+    }
+    return mem_set_size_classes(classes, count);
 }
 
 /**
- * Allocates a block of memory from the memory pool.
- * 
+ * Allocates a block, reporting how much of it may hold stale data.
+ *
  * @param requested_size: The size of memory to be allocated.
- * 
+ * @param dirty: If not NULL, set to how many leading bytes of the block may
+ *               be non-zero.
+ *
  * @return: Pointer to the allocated memory, or NULL if allocation fails.
  */
-void* mem_alloc(size_t requested_size) {
-    Block* current = free_list;
+static void* pool_alloc(size_t requested_size, size_t* dirty) {
+    if (dirty) {
+        *dirty = requested_size;
+    }
+    if (!pool_header) {
+        return NULL;
+    }
 
     if (requested_size == 0) {
         // If requested size is 0, return the first available free block's data pointer
         // but don't actually mark it as allocated or split it.
-        printf("Allocating minimal block for 0 bytes request\n");
-        return (void*)((char*)current + sizeof(Block)); // Return pointer to first block's data
+        mm_trace("Allocating minimal block for 0 bytes request\n");
+        return block_data(block_at(pool_header->arenas[0].first)); // Return pointer to first block's data
+    }
+
+    if (mmap_threshold != 0 && requested_size >= mmap_threshold && !pool_is_shared) {
+        if (dirty) {
+            *dirty = 0;  // Fresh mappings are zero-filled
+        }
+        return huge_alloc(requested_size);
     }
 
     // Align the requested size to ensure proper memory alignment
     requested_size = (requested_size + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
-    printf("Requested size: %zu\n", requested_size);
-
-    while (current != NULL) {
-        printf("Current block size: %zu, is_free: %d\n", current->size, current->is_free);
-        
-        if (current->is_free && current->size >= requested_size) {
-            // Calculate remaining size after allocation
-            size_t remaining_size = current->size - requested_size;
+    mm_trace("Requested size: %zu\n", requested_size);
+    if (__atomic_load_n(&profile_remaining, __ATOMIC_RELAXED) != 0) {
+        size_class_sample(requested_size);
+    }
 
-            if (remaining_size > sizeof(Block)) {
-                // Create a new block from the remaining memory
-                Block* new_block = (Block*)((char*)current + sizeof(Block) + requested_size);
-                new_block->size = remaining_size;
-                new_block->is_free = true;
-                new_block->next = current->next;
-                current->next = new_block;
-                
-                // Update the current block's size and mark it as allocated
-                current->size = requested_size;
+    // Round up to the size class when there is room for it, otherwise take
+    // the exact size. Start with the preferred arena and fall back to the others.
+    size_t rounded = size_class_round(requested_size);
+    size_t count = pool_header->arena_count;
+    size_t start = arena_pick();
+    for (size_t size = rounded;; size = requested_size) {
+        for (size_t k = 0; k < count; k++) {
+            void* block = arena_alloc(&pool_header->arenas[(start + k) % count], size, dirty);
+            if (block) {
+                pressure_check();
+                return block;
             }
-            
-            current->is_free = false;
-            printf("Allocated block of size: %zu\n", current->size);
-            return (void*)((char*)current + sizeof(Block));
         }
-        current = current->next;
+        if (size == requested_size) {
+            break;
+        }
     }
 
-    printf("No suitable block found for allocation\n");
+    mm_trace("No suitable block found for allocation\n");
     return NULL;  // No suitable block found
 }
 
+/**
+ * Allocates a block of memory from the memory pool.
+ *
+ * @param requested_size: The size of memory to be allocated.
+ *
+ * @return: Pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* mem_alloc(size_t requested_size) {
+    return pool_alloc(requested_size, NULL);
+}
+
+/**
+ * Returns every block in the calling thread's cache to the pool.
+ *
+ * Threads flush automatically when they exit; call this to hand cached
+ * memory back earlier, e.g. from a pressure callback.
+ */
+void mem_tcache_flush(void) {
+    bool current = mem_tcache.generation == __atomic_load_n(&mem_pool_generation, __ATOMIC_ACQUIRE);
+    for (size_t b = 0; b < MEM_TCACHE_BINS; b++) {
+        MemTcacheBin* bin = &mem_tcache.bins[b];
+        while (current && bin->head) {
+            void* block = bin->head;
+            bin->head = *(void**)block;
+            mem_free(block);
+        }
+        bin->head = NULL;  // Blocks of a pool that is gone are simply dropped
+        bin->count = 0;
+    }
+}
+
+static void tcache_thread_exit(void* unused) {
+    (void)unused;
+    mem_tcache_flush();
+}
+
+static void tcache_key_create(void) {
+    pthread_key_create(&tcache_key, tcache_thread_exit);
+}
+
+/**
+ * Slow path of mem_alloc_inline: refills the bin for a size from the pool.
+ *
+ * @param size: Requested size, at most MEM_TCACHE_MAX.
+ *
+ * @return: A block of at least size bytes, or NULL if the pool is full.
+ */
+void* mem_tcache_refill(size_t size) {
+    unsigned generation = __atomic_load_n(&mem_pool_generation, __ATOMIC_ACQUIRE);
+    if (mem_tcache.generation != generation) {
+        mem_tcache_flush();
+        mem_tcache.generation = generation;
+        pthread_once(&tcache_key_once, tcache_key_create);
+        pthread_setspecific(tcache_key, &mem_tcache);
+    }
+    if (size == 0 || size > MEM_TCACHE_MAX) {
+        return mem_alloc(size);
+    }
+
+    // Take a batch so the next misses are hits, filling the bin to half its limit
+    size_t bin_size = (size + 7) & ~(size_t)7;
+    MemTcacheBin* bin = &mem_tcache.bins[(size - 1) / 8];
+    void* block = mem_alloc(bin_size);
+    for (unsigned k = 1; block && k < MEM_TCACHE_BATCH && bin->count < MEM_TCACHE_LIMIT / 2; k++) {
+        void* extra = mem_alloc(bin_size);
+        if (!extra) {
+            break;
+        }
+        *(void**)extra = bin->head;
+        bin->head = extra;
+        bin->count++;
+    }
+    return block;
+}
+
+/**
+ * Allocates a block, waiting for other threads to free enough memory if the
+ * pool is full.
+ *
+ * @param requested_size: The size of memory to be allocated.
+ * @param timeout_ms: How long to wait in milliseconds, or a negative value to
+ *                    wait indefinitely.
+ *
+ * @return: Pointer to the allocated memory, or NULL if the timeout expired or
+ *          the request can never fit in an arena.
+ *
+ * Before parking, the pressure callbacks run so caches get a chance to give
+ * memory back. Frees in this process wake the caller directly; frees made
+ * by other processes sharing the pool are noticed within WAIT_POLL_MS.
+ */
+void* mem_alloc_wait(size_t requested_size, long timeout_ms) {
+    if (!pool_header) {
+        return NULL;
+    }
+    bool huge = mmap_threshold != 0 && requested_size >= mmap_threshold && !pool_is_shared;
+    if (huge || requested_size > pool_header->arena_span) {
+        return mem_alloc(requested_size);  // Waiting cannot help these
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeout_ms >= 0) {
+        timespec_add_ms(&deadline, timeout_ms);
+    }
+
+    // Registering before the first attempt means no free after it goes unseen
+    __atomic_add_fetch(&space_waiters, 1, __ATOMIC_SEQ_CST);
+    bool notified = false;
+    void* block = NULL;
+    for (;;) {
+        pthread_mutex_lock(&pressure_lock);
+        unsigned generation = free_generation;
+        pthread_mutex_unlock(&pressure_lock);
+
+        block = mem_alloc(requested_size);
+        if (block) {
+            break;
+        }
+        if (!notified) {
+            notified = true;
+            mem_tcache_flush();
+            pressure_notify();
+            continue;
+        }
+
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        if (timeout_ms >= 0 && timespec_cmp(&until, &deadline) >= 0) {
+            break;
+        }
+        if (pool_is_shared) {
+            timespec_add_ms(&until, WAIT_POLL_MS);
+            if (timeout_ms >= 0 && timespec_cmp(&until, &deadline) > 0) {
+                until = deadline;
+            }
+        } else {
+            until = deadline;
+        }
+
+        pthread_mutex_lock(&pressure_lock);
+        int rc = 0;
+        while (generation == free_generation && rc != ETIMEDOUT) {
+            if (timeout_ms < 0 && !pool_is_shared) {
+                rc = pthread_cond_wait(&space_freed, &pressure_lock);
+            } else {
+                rc = pthread_cond_timedwait(&space_freed, &pressure_lock, &until);
+            }
+        }
+        pthread_mutex_unlock(&pressure_lock);
+    }
+    __atomic_sub_fetch(&space_waiters, 1, __ATOMIC_SEQ_CST);
+    return block;
+}
+
+/**
+ * Sets the soft limit on pool usage.
+ *
+ * @param limit: Bytes in allocated blocks above which the pressure callbacks
+ *               run, or 0 to disable them (the default).
+ *
+ * The callbacks run once, from the allocating thread, when an allocation
+ * takes usage past the limit, and again only after frees have brought usage
+ * back under it. Huge blocks served by mmap do not count. Blocks parked in
+ * thread caches do: the allocating thread flushes its own cache before the
+ * callbacks run, and callbacks can ask other threads to call mem_tcache_flush.
+ */
+void mem_set_watermark(size_t limit) {
+    __atomic_store_n(&soft_limit, limit, __ATOMIC_RELAXED);
+    __atomic_store_n(&pressure_armed, true, __ATOMIC_RELEASE);
+}
+
+/**
+ * Registers a function to call when the pool comes under pressure.
+ *
+ * @param callback: Called with the bytes in use, the soft limit and context.
+ *                  It may free memory but runs on the allocating thread, so
+ *                  it should be quick.
+ * @param context: Passed back to the callback.
+ *
+ * @return: true on success, false if all MEM_MAX_PRESSURE_CALLBACKS slots
+ *          are taken.
+ */
+bool mem_add_pressure_callback(MemPressureCallback callback, void* context) {
+    bool added = false;
+    pthread_mutex_lock(&pressure_lock);
+    for (size_t i = 0; i < MEM_MAX_PRESSURE_CALLBACKS && callback; i++) {
+        if (!pressure_callbacks[i].callback) {
+            pressure_callbacks[i].callback = callback;
+            pressure_callbacks[i].context = context;
+            added = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pressure_lock);
+    if (!added) {
+        printf("No room for another pressure callback\n");
+    }
+    return added;
+}
+
+/**
+ * Removes a callback registered with mem_add_pressure_callback.
+ *
+ * @return: true if the callback and context were registered.
+ */
+bool mem_remove_pressure_callback(MemPressureCallback callback, void* context) {
+    bool removed = false;
+    pthread_mutex_lock(&pressure_lock);
+    for (size_t i = 0; i < MEM_MAX_PRESSURE_CALLBACKS; i++) {
+        if (pressure_callbacks[i].callback == callback && pressure_callbacks[i].context == context) {
+            pressure_callbacks[i].callback = NULL;
+            pressure_callbacks[i].context = NULL;
+            removed = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pressure_lock);
+    return removed;
+}
+
+/**
+ * Returns the number of bytes held by allocated pool blocks.
+ */
+size_t mem_used(void) {
+    return pool_header ? __atomic_load_n(&pool_header->used, __ATOMIC_RELAXED) : 0;
+}
+
+/**
+ * Returns the total size of the memory pool, or 0 if there is none.
+ */
+size_t mem_size(void) {
+    return pool_header ? pool_bytes() : 0;
+}
+
+
+/**
+ * Marks a block free and merges it with its free neighbours.
+ * The caller must hold the arena lock.
+ */
+static void block_release(Arena* arena, Block* header) {
+    if (!header->is_free) {
+        __atomic_sub_fetch(&pool_header->used, block_bytes(header), __ATOMIC_RELAXED);
+    }
+    header->is_free = true;
+    header->dirty = header->size;
+
+    // Coalesce adjacent free blocks
+    Block* current = block_at(arena->first);
+    Block* next;
+    while ((next = block_next(current)) != NULL) {
+        if (current->is_free && next->is_free) {
+            block_merge(current, next);
+            continue;  // The merged block may border another free block
+        }
+        current = next;
+    }
+}
 
 /**
  * Frees a previously allocated block of memory.
- * 
+ *
  * @param block: The pointer to the memory block to be freed.
  */
 void mem_free(void* block) {
-    if (!block) return;
+    // Ignore pointers that were never handed out by this pool
+    Block* header = block_of(block);
+    if (!header) {
+        if (block && huge_count > 0) {
+            huge_free(block);
+        }
+        return;
+    }
 
-    Block* header = (Block*)((char*)block - sizeof(Block));
-    header->is_free = true;
+    Arena* arena = arena_of(header);
+    pool_lock(arena);
+    block_release(arena, header);
+    pool_unlock(arena);
+    pool_released();
+}
 
-    // Coalesce adjacent free blocks
-    Block* current = free_list;
-    while (current != NULL && current->next != NULL) {
-        if (current->is_free && current->next->is_free) {
-            current->size += sizeof(Block) + current->next->size;
-            current->next = current->next->next;
+// Resizes a huge block in place or by remapping, without copying
+static void* huge_resize(void* block, size_t size) {
+    pthread_mutex_lock(&huge_lock);
+    HugeBlock* slot = huge_find(block);
+    if (!slot) {
+        pthread_mutex_unlock(&huge_lock);
+        return NULL;
+    }
+    size_t length = huge_length(size);
+    void* data = block;
+    if (length != slot->length) {
+        data = mremap(block, slot->length, length, MREMAP_MAYMOVE);
+        if (data == MAP_FAILED) {
+            pthread_mutex_unlock(&huge_lock);
+            return NULL;
         }
-        current = current->next;
     }
+    HugeBlock entry = {data, size, length};
+    huge_remove(slot);
+    huge_insert(entry);  // Cannot fail: the table never grows on reinsertion
+    pthread_mutex_unlock(&huge_lock);
+    return data;
 }
 
 /**
  * Resizes an allocated memory block.
- * 
+ *
  * @param block: The pointer to the memory block to be resized.
  * @param size: The new size of the memory block.
- * 
+ *
  * @return: Pointer to the resized memory block, or NULL if resizing fails.
  */
 void* mem_resize(void* block, size_t size) {
@@ -130,30 +1436,604 @@ void* mem_resize(void* block, size_t size) {
         return mem_alloc(size);  // If block is NULL, allocate a new block
     }
 
-    Block* header = (Block*)((char*)block - sizeof(Block));
+    Block* header = block_of(block);
+    if (!header) {
+        return huge_resize(block, size);
+    }
 
-    if (header->size >= size) {
+    if (block_bytes(header) >= size) {
         return block;  // No need to resize if the current block is large enough
     }
 
     // Allocate a new block and copy the old content
     void* new_block = mem_alloc(size);
     if (new_block) {
-        memcpy(new_block, block, header->size);  // Copy old content to new block
+        memcpy(new_block, block, block_bytes(header));  // Copy old content to new block
         mem_free(block);  // Free the old block
     }
 
     return new_block;
 }
 
+// Clears memory, bypassing the cache for blocks too large to stay in it
+static void zero_bytes(void* ptr, size_t length) {
+#ifdef __SSE2__
+    if (length >= NONTEMPORAL_THRESHOLD) {
+        char* p = ptr;
+        char* end = p + length;
+        while (((uintptr_t)p & 15) != 0) {
+            *p++ = 0;
+        }
+        __m128i zero = _mm_setzero_si128();
+        for (; p + 64 <= end; p += 64) {
+            _mm_stream_si128((__m128i*)p, zero);
+            _mm_stream_si128((__m128i*)(p + 16), zero);
+            _mm_stream_si128((__m128i*)(p + 32), zero);
+            _mm_stream_si128((__m128i*)(p + 48), zero);
+        }
+        _mm_sfence();  // Order the streaming stores before the block is handed out
+        memset(p, 0, end - p);
+        return;
+    }
+#endif
+    memset(ptr, 0, length);
+}
+
+/**
+ * Allocates zero-initialized memory for an array.
+ *
+ * @param count: Number of elements.
+ * @param size: Size of each element.
+ *
+ * @return: Pointer to the zeroed memory, or NULL if count * size overflows
+ *          or allocation fails.
+ *
+ * Only the part of the block that may hold old data is cleared: space the
+ * pool has never handed out, pages released by mem_trim() and huge blocks
+ * fresh from mmap are already zero.
+ */
+void* mem_calloc(size_t count, size_t size) {
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) {
+        return NULL;
+    }
+    if (total == 0) {
+        return mem_alloc(0);
+    }
+
+    size_t dirty;
+    void* block = pool_alloc(total, &dirty);
+    if (block && dirty > 0) {
+        zero_bytes(block, dirty < total ? dirty : total);
+    }
+    return block;
+}
+
+/**
+ * Returns the whole pages inside free blocks to the operating system.
+ *
+ * @return: Number of bytes released.
+ *
+ * Released pages read back as zero, so mem_calloc() does not clear them
+ * again. The pool keeps its size; pages are faulted back in on use.
+ */
+size_t mem_trim(void) {
+    if (!pool_header) {
+        return 0;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t released = 0;
+    for (size_t k = 0; k < pool_header->arena_count; k++) {
+        Arena* arena = &pool_header->arenas[k];
+        pool_lock(arena);
+        for (Block* current = block_at(arena->first); current != NULL; current = block_next(current)) {
+            if (!current->is_free || current->dirty == 0) {
+                continue;
+            }
+            char* start = block_data(current);
+            char* dirty_end = start + (size_t)current->dirty * GRANULE;
+            char* first = (char*)(((uintptr_t)start + page - 1) & ~(uintptr_t)(page - 1));
+            char* last = (char*)((uintptr_t)dirty_end & ~(uintptr_t)(page - 1));
+            if (last <= first) {
+                continue;  // No whole dirty page to give back
+            }
+            size_t length = last - first;
+
+            int rc;
+            if (pool_is_shared) {
+                rc = madvise(first, length, MADV_REMOVE);  // Also drops the shm pages
+            } else if (pool_is_restored) {
+                // A private file mapping would refault the snapshot contents
+                void* fresh = mmap(first, length, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+                rc = fresh == MAP_FAILED ? -1 : 0;
+            } else {
+                rc = madvise(first, length, MADV_DONTNEED);
+            }
+            if (rc != 0) {
+                continue;
+            }
+
+            // Clear the partial page after the released range so the block
+            // is zero from its first released page onwards
+            memset(last, 0, dirty_end - last);
+            current->dirty = (uint32_t)((first - start) / GRANULE);
+            released += length;
+        }
+        pool_unlock(arena);
+    }
+    return released;
+}
+
+/**
+ * Converts a pointer into the pool to an offset from the start of the pool.
+ *
+ * @param ptr: Pointer previously returned by mem_alloc (or into such a block).
+ *
+ * @return: The offset, or MEM_NULL_OFFSET if ptr is NULL or outside the pool.
+ */
+size_t mem_offset(const void* ptr) {
+    if (!ptr || !pool_header) {
+        return NULL_OFFSET;
+    }
+    if ((const char*)ptr < (const char*)memory_pool ||
+        (const char*)ptr >= (const char*)memory_pool + pool_bytes()) {
+        return NULL_OFFSET;
+    }
+    return (size_t)((const char*)ptr - (const char*)memory_pool);
+}
+
+/**
+ * Converts an offset produced by mem_offset() (possibly in another process
+ * sharing the pool) back to a pointer in this process.
+ *
+ * @param offset: Offset from the start of the pool.
+ *
+ * @return: The pointer, or NULL for MEM_NULL_OFFSET or an out-of-range offset.
+ */
+void* mem_from_offset(size_t offset) {
+    if (offset == NULL_OFFSET || !pool_header || offset >= pool_bytes()) {
+        return NULL;
+    }
+    return (char*)memory_pool + offset;
+}
+
+// Handle table entry for a handle value, or NULL if the handle is not in use
+static HandleEntry* handle_entry(MemHandle handle) {
+    if (!pool_header || handle == MEM_NULL_HANDLE ||
+        handle > __atomic_load_n(&pool_header->handle_next, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    HandleEntry* entry = &handle_table[handle - 1];
+    return entry->in_use ? entry : NULL;
+}
+
+// Arena holding a handle's block. Blocks only move within their arena, so
+// this is stable even while mem_compact runs.
+static Arena* handle_arena(HandleEntry* entry) {
+    size_t offset = (size_t)__atomic_load_n(&entry->offset, __ATOMIC_RELAXED) * GRANULE;
+    return &pool_header->arenas[offset / pool_header->arena_span];
+}
+
+/**
+ * Allocates a movable block of memory.
+ *
+ * @param size: The size of memory to be allocated.
+ *
+ * @return: A handle for the block, or MEM_NULL_HANDLE if allocation fails.
+ *
+ * Unlike blocks from mem_alloc, movable blocks may be relocated by
+ * mem_compact() whenever they are not locked. Use mem_hlock() to get a
+ * pointer to the data and mem_hunlock() once done with it, and release the
+ * block with mem_hfree().
+ */
+MemHandle mem_halloc(size_t size) {
+    if (!pool_header || size == 0) {
+        return MEM_NULL_HANDLE;
+    }
+    void* data = mem_alloc(size);
+    if (!data) {
+        return MEM_NULL_HANDLE;
+    }
+
+    lock_mutex(&pool_header->handle_lock);
+    MemHandle handle = pool_header->handle_free;
+    HandleEntry* entry;
+    if (handle != MEM_NULL_HANDLE) {
+        entry = &handle_table[handle - 1];
+        pool_header->handle_free = entry->offset;
+    } else {
+        handle = pool_header->handle_next + 1;
+        entry = &handle_table[handle - 1];
+    }
+    entry->offset = (uint32_t)(mem_offset(data) / GRANULE);
+    entry->locks = 0;
+    entry->in_use = true;
+    __atomic_store_n(&pool_header->handle_next,
+                     handle > pool_header->handle_next ? handle : pool_header->handle_next,
+                     __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&pool_header->handle_lock);
+
+    // Only now may mem_compact move the block
+    Block* header = block_of(data);
+    Arena* arena = arena_of(header);
+    pool_lock(arena);
+    header->handle = (uint32_t)handle;
+    pool_unlock(arena);
+    return handle;
+}
+
+/**
+ * Pins a movable block and returns a pointer to its data.
+ *
+ * @param handle: Handle returned by mem_halloc.
+ *
+ * @return: Pointer to the data, valid until the matching mem_hunlock(), or
+ *          NULL for an invalid handle. Locks nest.
+ */
+void* mem_hlock(MemHandle handle) {
+    HandleEntry* entry = handle_entry(handle);
+    if (!entry) {
+        return NULL;
+    }
+    Arena* arena = handle_arena(entry);
+    pool_lock(arena);
+    entry->locks++;
+    void* data = (char*)memory_pool + (size_t)entry->offset * GRANULE;
+    pool_unlock(arena);
+    return data;
+}
+
+/**
+ * Releases a pin taken with mem_hlock(). Once every pin is released the
+ * block may be moved again, and pointers to it must no longer be used.
+ *
+ * @param handle: Handle returned by mem_halloc.
+ */
+void mem_hunlock(MemHandle handle) {
+    HandleEntry* entry = handle_entry(handle);
+    if (!entry) {
+        return;
+    }
+    Arena* arena = handle_arena(entry);
+    pool_lock(arena);
+    if (entry->locks > 0) {
+        entry->locks--;
+    }
+    pool_unlock(arena);
+}
+
+/**
+ * Frees a movable block and its handle.
+ *
+ * @param handle: Handle returned by mem_halloc.
+ */
+void mem_hfree(MemHandle handle) {
+    HandleEntry* entry = handle_entry(handle);
+    if (!entry) {
+        return;
+    }
+    Arena* arena = handle_arena(entry);
+    pool_lock(arena);
+    block_release(arena, block_at((size_t)entry->offset * GRANULE));
+    pool_unlock(arena);
+    pool_released();
+
+    lock_mutex(&pool_header->handle_lock);
+    entry->in_use = false;
+    entry->offset = (uint32_t)pool_header->handle_free;
+    pool_header->handle_free = handle;
+    pthread_mutex_unlock(&pool_header->handle_lock);
+}
+
+/**
+ * Compacts one arena by sliding unlocked movable blocks down into the free
+ * block in front of them. The caller must hold the arena lock.
+ *
+ * @return: Number of bytes moved, which stops growing once budget is reached.
+ */
+static size_t arena_compact(Arena* arena, size_t budget) {
+    size_t moved = 0;
+    Block* current = block_at(arena->first);
+    while (current != NULL && moved < budget) {
+        Block* next = block_next(current);
+        if (!current->is_free || next == NULL) {
+            current = next;
+            continue;
+        }
+        if (next->is_free) {
+            block_merge(current, next);
+            continue;
+        }
+
+        // Blocks from mem_alloc and locked movable blocks stay where they are
+        HandleEntry* entry = next->handle ? &handle_table[next->handle - 1] : NULL;
+        if (entry == NULL || entry->locks > 0) {
+            current = next;
+            continue;
+        }
+
+        size_t gap_offset = block_offset(current);
+        uint32_t gap_size = current->size;
+        uint32_t block_size = next->size;
+        uint32_t handle = next->handle;
+        memmove((char*)memory_pool + gap_offset, block_data(next), block_bytes(next));
+        *next = (Block){0};  // The block no longer starts here
+
+        // The block takes the gap's place and the gap moves up behind it,
+        // where the loop merges it with any free block that follows
+        current->size = block_size;
+        current->is_free = false;
+        current->handle = handle;
+        Block* gap = block_next(current);
+        gap->size = gap_size;
+        gap->is_free = true;
+        gap->dirty = gap_size;
+        __atomic_store_n(&entry->offset, (uint32_t)(gap_offset / GRANULE), __ATOMIC_RELAXED);
+
+        moved += block_bytes(current);
+        current = gap;
+    }
+    return moved;
+}
+
+/**
+ * Moves unlocked movable blocks towards the start of their arena so that the
+ * free space between them merges into large free blocks.
+ *
+ * @param budget: Upper bound on the number of bytes to move in this call (the
+ *                last move may overshoot it by one block). Calling repeatedly
+ *                with a small budget compacts the pool incrementally; each
+ *                call only holds one arena lock at a time.
+ *
+ * @return: Number of bytes moved; 0 once nothing more can be compacted.
+ */
+size_t mem_compact(size_t budget) {
+    if (!pool_header) {
+        return 0;
+    }
+    size_t moved = 0;
+    for (size_t k = 0; k < pool_header->arena_count && moved < budget; k++) {
+        Arena* arena = &pool_header->arenas[k];
+        pool_lock(arena);
+        moved += arena_compact(arena, budget - moved);
+        pool_unlock(arena);
+    }
+    return moved;
+}
+
+/**
+ * Records the application's root object in the pool header, so that it can be
+ * found again after mem_restore().
+ *
+ * @param ptr: Pointer into the pool, or NULL to clear the root.
+ */
+void mem_set_root(void* ptr) {
+    if (pool_header) {
+        pool_header->root = mem_offset(ptr);
+    }
+}
+
+/**
+ * Returns the root object recorded with mem_set_root(), or NULL if none.
+ */
+void* mem_get_root(void) {
+    return pool_header ? mem_from_offset(pool_header->root) : NULL;
+}
+
+/**
+ * Finds how much of the pool and of the header table holds live data.
+ * The caller must hold every arena lock.
+ *
+ * @param data_end: Set to the end of the last allocated payload.
+ * @param table_end: Set to the end of the last header in use.
+ */
+static void pool_used_extent(size_t* data_end, size_t* table_end) {
+    *data_end = 0;
+    *table_end = 0;
+    for (size_t k = 0; k < pool_header->arena_count; k++) {
+        Block* last = block_at(pool_header->arenas[k].first);
+        for (Block* next = block_next(last); next != NULL; next = block_next(next)) {
+            last = next;
+        }
+        size_t arena_end = block_offset(last) + (last->is_free ? 0 : block_bytes(last));
+        size_t slots_end = (size_t)(last + 1 - block_table) * sizeof(Block);
+        *data_end = arena_end > *data_end ? arena_end : *data_end;
+        *table_end = slots_end > *table_end ? slots_end : *table_end;
+    }
+}
+
+// Writes len bytes at the given file offset, retrying short writes
+static bool write_at(int fd, const void* src, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t written = pwrite(fd, src, len, offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        src = (const char*)src + written;
+        len -= (size_t)written;
+        offset += written;
+    }
+    return true;
+}
+
+/**
+ * Writes an image of the memory pool to a file.
+ *
+ * @param path: File to write. It is replaced atomically, so an existing
+ *              snapshot survives a failed write.
+ *
+ * @return: true on success, false if there is no pool or the write failed.
+ *
+ * Only the used parts of the pool are written. The image records the address
+ * the pool lives at, so mem_restore() can bring it back at the same address
+ * and raw pointers stored inside the pool stay valid.
+ */
+bool mem_snapshot(const char* path) {
+    if (!pool_header) {
+        return false;
+    }
+
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        printf("Snapshot path too long\n");
+        return false;
+    }
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        printf("Opening snapshot file failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    for (size_t k = 0; k < pool_header->arena_count; k++) {
+        pool_lock(&pool_header->arenas[k]);
+    }
+    pool_header->base = pool_header;
+    size_t data_end, table_end;
+    pool_used_extent(&data_end, &table_end);
+
+    // Header and pool first, then the used part of the header table at its
+    // place in the mapping, leaving a hole in the file for the unused pool
+    size_t table_offset = pool_header->table_offset;
+    bool ok = write_at(fd, pool_header, POOL_HEADER_SIZE + data_end, 0) &&
+              write_at(fd, block_table, table_end, (off_t)table_offset) &&
+              write_at(fd, handle_table, pool_header->handle_next * sizeof(HandleEntry),
+                       (off_t)pool_header->handle_offset);
+    for (size_t k = pool_header->arena_count; k-- > 0;) {
+        pool_unlock(&pool_header->arenas[k]);
+    }
+
+    if (fsync(fd) != 0) {
+        ok = false;
+    }
+    close(fd);
+    if (!ok || rename(tmp_path, path) != 0) {
+        printf("Writing snapshot failed: %s\n", strerror(errno));
+        unlink(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Replaces the current memory pool with one restored from a snapshot.
+ *
+ * @param path: File written by mem_snapshot().
+ *
+ * @return: true on success, false if the file is missing or not a snapshot.
+ *          On failure the current pool is kept.
+ *
+ * The current pool, if any, is released as by mem_deinit() once the
+ * snapshot is mapped: unmapped, and unlinked if this process created it as
+ * a shared pool. Blocks and handles from it are invalid afterwards.
+ *
+ * The file is mapped copy-on-write rather than read, so restoring is
+ * independent of the pool size and pages are only loaded when touched.
+ * The pool is placed at the address it was saved from when that address is
+ * free. Otherwise it is mapped elsewhere: the allocator itself only uses
+ * offsets and keeps working, and mem_relocation_delta() tells the caller how
+ * far raw pointers stored in the pool have to be moved.
+ */
+bool mem_restore(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Opening snapshot file failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    PoolHeader saved;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)POOL_HEADER_SIZE ||
+        pread(fd, &saved, sizeof(saved), 0) != (ssize_t)sizeof(saved) ||
+        saved.magic != POOL_MAGIC || saved.arena_count == 0 || saved.arena_count > MEM_MAX_ARENAS ||
+        saved.mapping_size != pool_mapping_size(saved.size, saved.arena_count) ||
+        saved.table_offset != pool_table_offset(saved.size, saved.arena_count) ||
+        saved.handle_offset != pool_handle_offset(saved.size, saved.arena_count) ||
+        (size_t)st.st_size > saved.mapping_size) {
+        printf("Not a memory pool snapshot: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    // Reserve the whole pool, preferably where it lived when it was saved
+    void* base = mmap(saved.base, saved.mapping_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+    if (base == MAP_FAILED) {
+        base = mmap(NULL, saved.mapping_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    if (base == MAP_FAILED ||
+        mmap(base, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        printf("Memory pool allocation failed\n");
+        if (base != MAP_FAILED) {
+            munmap(base, saved.mapping_size);
+        }
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    // The locks were held while the image was written; start from fresh ones
+    PoolHeader* header = (PoolHeader*)base;
+    if (!pool_init_locks(header, false)) {
+        munmap(base, saved.mapping_size);
+        return false;
+    }
+
+    // The snapshot is usable: only now let go of the current pool, so a
+    // failed restore leaves it in place
+    mem_deinit();
+    pool_relocation = (char*)base - (char*)saved.base;
+    header->base = base;
+    pool_is_shared = false;
+    pool_is_owner = false;
+    pool_is_restored = true;
+    pool_attach(header);
+    return true;
+}
+
+/**
+ * Returns how many bytes the pool moved when it was restored by mem_restore(),
+ * or 0 if it came back at its saved address (or was never restored).
+ */
+ptrdiff_t mem_relocation_delta(void) {
+    return pool_relocation;
+}
+
 /**
  * De-initializes the memory pool.
- * 
+ *
  * This function frees the memory pool and resets all related variables.
+ * A shared pool is unmapped from this process only; its creator also removes
+ * the name so no new process can attach.
  */
 void mem_deinit() {
-    free(memory_pool);  // Free the memory pool
+    if (pool_header) {
+        if (!pool_is_shared) {
+            for (size_t k = 0; k < pool_header->arena_count; k++) {
+                pthread_mutex_destroy(&pool_header->arenas[k].lock);
+            }
+            pthread_mutex_destroy(&pool_header->handle_lock);
+        }
+        munmap(pool_header, pool_header->mapping_size);  // Free the memory pool
+    }
+    if (pool_is_shared && pool_is_owner) {
+        shm_unlink(pool_name);
+    }
+    huge_free_all();
+    __atomic_add_fetch(&mem_pool_generation, 1, __ATOMIC_RELEASE);  // Drop every thread cache
+    pool_header = NULL;
     memory_pool = NULL;
     memory_pool_size = 0;
-    free_list = NULL;
+    block_table = NULL;
+    handle_table = NULL;
+    pool_is_shared = false;
+    pool_is_owner = false;
+    pool_is_restored = false;
+    pool_relocation = 0;
 }
@@ -4,7 +4,35 @@
 #include <stddef.h>  // For size_t
 #include <stdbool.h> // For bool
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 
+// Offset returned by mem_offset() for pointers outside the pool
+#define MEM_NULL_OFFSET ((size_t)-1)
+
+// Handle to a movable block (see mem_halloc), MEM_NULL_HANDLE if none
+typedef size_t MemHandle;
+#define MEM_NULL_HANDLE ((MemHandle)0)
+
+// Maximum number of arenas a pool can be split into
+#define MEM_MAX_ARENAS 64
+
+// How allocations choose an arena (sub-heap) of the pool
+typedef enum {
+    MEM_ARENA_SINGLE,      // One heap shared by all threads
+    MEM_ARENA_PER_THREAD,  // One heap per thread
+    MEM_ARENA_PER_CPU      // One heap per CPU, picked with sched_getcpu()
+} MemArenaMode;
+
+// Maximum number of registered memory pressure callbacks
+#define MEM_MAX_PRESSURE_CALLBACKS 16
+
+// Maximum number of size classes requests can be rounded up to
+#define MEM_MAX_SIZE_CLASSES 32
+
+// Called when pool usage passes the soft limit (see mem_set_watermark)
+typedef void (*MemPressureCallback)(size_t used, size_t limit, void* context);
 
 // Declare memory management functions
 void mem_init(size_t size);
@@ -13,4 +41,118 @@ void mem_free(void* block);
 void* mem_resize(void* block, size_t size);
 void mem_deinit();
 
-#endif // MEMORY_MANAGER_H
\ No newline at end of file
+// Zero-initialized allocation and returning free pages to the system
+void* mem_calloc(size_t count, size_t size);
+size_t mem_trim(void);
+
+// Backpressure: blocking allocation and soft-limit callbacks
+void* mem_alloc_wait(size_t size, long timeout_ms);
+void mem_set_watermark(size_t limit);
+bool mem_add_pressure_callback(MemPressureCallback callback, void* context);
+bool mem_remove_pressure_callback(MemPressureCallback callback, void* context);
+size_t mem_used(void);
+size_t mem_size(void);
+
+// Size classes, fixed or derived from a profile of request sizes
+bool mem_profile_sizes(size_t samples, size_t class_count);
+bool mem_set_size_classes(const size_t* classes, size_t count);
+size_t mem_get_size_classes(size_t* classes, size_t max);
+bool mem_save_size_classes(const char* path);
+bool mem_load_size_classes(const char* path);
+
+// Serve large requests directly with mmap
+void mem_set_mmap_threshold(size_t threshold);
+
+// Pools split into per-thread or per-CPU arenas
+bool mem_init_arenas(size_t size, MemArenaMode mode, size_t arena_count);
+
+// Shared-memory pools, usable from several processes at once
+bool mem_init_shared(const char* name, size_t size);
+size_t mem_offset(const void* ptr);
+void* mem_from_offset(size_t offset);
+
+// Movable blocks and heap compaction
+MemHandle mem_halloc(size_t size);
+void* mem_hlock(MemHandle handle);
+void mem_hunlock(MemHandle handle);
+void mem_hfree(MemHandle handle);
+size_t mem_compact(size_t budget);
+
+// Thread caches for small blocks. mem_alloc_inline and mem_free_inline are
+// served from per-thread bins without a call into the library; the library
+// is only entered to refill an empty bin or drain a full one.
+//
+// Blocks parked in a bin still count as used: mem_used and the soft limit
+// (see mem_set_watermark) include them. A thread's cache goes back to the
+// pool when the thread exits or calls mem_tcache_flush, and before the
+// pressure callbacks run on it; caches of other threads stay where they are.
+#define MEM_TCACHE_BINS 16                       // Bins for sizes 8, 16, ..., 128
+#define MEM_TCACHE_MAX (MEM_TCACHE_BINS * 8)     // Largest size served from a bin
+#define MEM_TCACHE_LIMIT 64                      // Blocks a bin keeps before frees go to the pool
+#define MEM_TCACHE_BATCH 16                      // Blocks taken from the pool per refill
+
+typedef struct MemTcacheBin {
+    void* head;         // Free blocks, linked through their first word
+    unsigned count;     // Blocks in the list
+} MemTcacheBin;
+
+typedef struct MemTcache {
+    unsigned generation;  // mem_pool_generation the blocks belong to
+    MemTcacheBin bins[MEM_TCACHE_BINS];
+} MemTcache;
+
+extern __thread MemTcache mem_tcache;
+extern unsigned mem_pool_generation;
+void* mem_tcache_refill(size_t size);
+void mem_tcache_flush(void);
+
+/**
+ * Allocates a block, from the calling thread's cache for small sizes.
+ *
+ * With a constant size (e.g. sizeof(Node)) the bin is picked at compile time
+ * and a hit is a few loads and stores. Cached blocks count as in use (see above).
+ */
+static inline void* mem_alloc_inline(size_t size) {
+    if (size - 1 < MEM_TCACHE_MAX &&
+        mem_tcache.generation == __atomic_load_n(&mem_pool_generation, __ATOMIC_RELAXED)) {
+        MemTcacheBin* bin = &mem_tcache.bins[(size - 1) / 8];
+        void* block = bin->head;
+        if (block) {
+            bin->head = *(void**)block;
+            bin->count--;
+            return block;
+        }
+    }
+    return size - 1 < MEM_TCACHE_MAX ? mem_tcache_refill(size) : mem_alloc(size);
+}
+
+/**
+ * Frees a block to the calling thread's cache. size must be the size the
+ * block was allocated with; blocks may also be freed with mem_free.
+ */
+static inline void mem_free_inline(void* block, size_t size) {
+    if (block && size - 1 < MEM_TCACHE_MAX &&
+        mem_tcache.generation == __atomic_load_n(&mem_pool_generation, __ATOMIC_RELAXED)) {
+        MemTcacheBin* bin = &mem_tcache.bins[(size - 1) / 8];
+        if (bin->count < MEM_TCACHE_LIMIT) {
+            *(void**)block = bin->head;
+            bin->head = block;
+            bin->count++;
+            return;
+        }
+    }
+    mem_free(block);
+}
+
+// Persistent snapshots of the pool
+bool mem_snapshot(const char* path);
+bool mem_restore(const char* path);
+ptrdiff_t mem_relocation_delta(void);
+void mem_set_root(void* ptr);
+void* mem_get_root(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEMORY_MANAGER_H
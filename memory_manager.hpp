@@ -0,0 +1,127 @@
+#ifndef MEMORY_MANAGER_HPP
+#define MEMORY_MANAGER_HPP
+
+// C++ adapters over the memory pool: a std::pmr::memory_resource and an
+// allocator for standard containers. Both allocate from the global pool set
+// up with mem_init (or one of its variants), so the pool must outlive every
+// container using them. Requires C++17.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include "memory_manager.h"
+
+namespace mm {
+
+namespace detail {
+
+// Alignment every pool block has
+constexpr std::size_t pool_alignment = sizeof(std::size_t);
+
+// Allocates from the pool with any power-of-two alignment. Stricter
+// alignments over-allocate and keep the block's address just below the
+// aligned pointer, where deallocate finds it.
+inline void* allocate(std::size_t bytes, std::size_t alignment) {
+    if (bytes == 0) {
+        bytes = 1;  // mem_alloc(0) does not allocate, so its pointer cannot be freed
+    }
+    if (alignment <= pool_alignment) {
+        void* block = mem_alloc(bytes);
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        return block;
+    }
+    if (bytes > SIZE_MAX - alignment) {
+        throw std::bad_alloc();
+    }
+    void* block = mem_alloc(bytes + alignment);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(block) + sizeof(void*);
+    void** aligned = reinterpret_cast<void**>((start + alignment - 1) & ~(alignment - 1));
+    aligned[-1] = block;
+    return aligned;
+}
+
+inline void deallocate(void* ptr, std::size_t alignment) {
+    if (ptr && alignment > pool_alignment) {
+        ptr = static_cast<void**>(ptr)[-1];
+    }
+    mem_free(ptr);
+}
+
+}  // namespace detail
+
+/**
+ * Polymorphic memory resource backed by the pool.
+ *
+ * Throws std::bad_alloc when the pool has no room. All instances draw from
+ * the same pool, so any one can free memory allocated by another.
+ */
+class pool_resource : public std::pmr::memory_resource {
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        return detail::allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t, std::size_t alignment) override {
+        detail::deallocate(ptr, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return dynamic_cast<const pool_resource*>(&other) != nullptr;
+    }
+};
+
+// Shared instance, e.g. for std::pmr::set_default_resource
+inline pool_resource* pool_memory_resource() {
+    static pool_resource resource;
+    return &resource;
+}
+
+/**
+ * Stateless allocator for standard containers, backed by the pool.
+ *
+ * @tparam T: Element type.
+ *
+ * All instances compare equal, so containers can swap and move memory
+ * between each other freely.
+ */
+template <typename T>
+class allocator {
+public:
+    using value_type = T;
+
+    allocator() noexcept = default;
+
+    template <typename U>
+    allocator(const allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(detail::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t) noexcept {
+        detail::deallocate(ptr, alignof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const allocator<T>&, const allocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const allocator<T>&, const allocator<U>&) noexcept {
+    return false;
+}
+
+}  // namespace mm
+
+#endif // MEMORY_MANAGER_HPP
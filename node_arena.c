@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory_manager.h"
+#include "node_arena.h"
+
+// Bytes of pool an arena of capacity slots takes, header included
+size_t node_arena_bytes(size_t slot_size, size_t capacity) {
+    return sizeof(NodeArena) + slot_size * capacity;
+}
+
+// Allocate an arena of capacity slots as a single pool block
+NodeArena* node_arena_create(size_t slot_size, size_t capacity) {
+    slot_size = (slot_size + 3) & ~(size_t)3;  // Room and alignment for the free link
+    if (capacity == 0 || capacity >= NODE_ARENA_NONE || slot_size > UINT32_MAX) {
+        printf("Invalid node arena capacity.\n");
+        return NULL;
+    }
+    NodeArena* arena = (NodeArena*)mem_alloc(node_arena_bytes(slot_size, capacity));
+    if (arena == NULL) {
+        printf("Memory allocation for node arena failed.\n");
+        return NULL;
+    }
+    arena->magic = NODE_ARENA_MAGIC;
+    arena->slot_size = (uint32_t)slot_size;
+    arena->capacity = (uint32_t)capacity;
+    arena->used = 0;
+    arena->free_head = NODE_ARENA_NONE;
+    arena->bump = 0;
+    return arena;
+}
+
+// Return the arena's block to the pool; its slots become invalid
+void node_arena_destroy(NodeArena* arena) {
+    if (arena != NULL) {
+        arena->magic = 0;
+        mem_free(arena);
+    }
+}
+
+// Take a slot: the most recently freed one, else the next never-used one
+void* node_arena_alloc(NodeArena* arena) {
+    uint32_t index = arena->free_head;
+    if (index != NODE_ARENA_NONE) {
+        memcpy(&arena->free_head, node_arena_slot(arena, index), sizeof(uint32_t));
+    } else if (arena->bump < arena->capacity) {
+        index = arena->bump++;
+    } else {
+        return NULL;
+    }
+    arena->used++;
+    return node_arena_slot(arena, index);
+}
+
+/**
+ * Take up to count never-used slots as one contiguous run, in a single step.
+ * Freed slots are not used, so the run may be shorter than count even
+ * though node_arena_alloc could still hand out more.
+ *
+ * @param arena: Arena to take the slots from.
+ * @param count: Slots wanted.
+ * @param taken: Receives the number of slots in the run.
+ * @return First slot of the run, NULL if no never-used slots are left.
+ */
+void* node_arena_alloc_run(NodeArena* arena, size_t count, size_t* taken) {
+    size_t left = arena->capacity - arena->bump;
+    *taken = count < left ? count : left;
+    if (*taken == 0) {
+        return NULL;
+    }
+    void* first = node_arena_slot(arena, arena->bump);
+    arena->bump += (uint32_t)*taken;
+    arena->used += (uint32_t)*taken;
+    return first;
+}
+
+// Give a slot back to the arena
+void node_arena_free(NodeArena* arena, void* slot) {
+    memcpy(slot, &arena->free_head, sizeof(uint32_t));
+    arena->free_head = node_arena_index(arena, slot);
+    arena->used--;
+}
@@ -0,0 +1,49 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Index of no slot, used to end free lists and index-linked lists
+#define NODE_ARENA_NONE UINT32_MAX
+
+// Fixed-size slots carved from one contiguous pool block. Free slots are
+// chained by 32-bit index through their first four bytes, so allocating and
+// freeing a slot is a pop and a push with no allocator header per slot. The
+// arena holds no pointers and can be found again after its pool moves.
+typedef struct NodeArena {
+    uint32_t magic;       // NODE_ARENA_MAGIC while the arena is live
+    uint32_t slot_size;   // Bytes per slot, a multiple of 4
+    uint32_t capacity;    // Number of slots
+    uint32_t used;        // Slots handed out
+    uint32_t free_head;   // First freed slot, NODE_ARENA_NONE if none
+    uint32_t bump;        // Slots from here on have never been used
+} NodeArena;
+
+#define NODE_ARENA_MAGIC 0x4e415245u  // "NARE"
+
+NodeArena* node_arena_create(size_t slot_size, size_t capacity);
+void node_arena_destroy(NodeArena* arena);
+void* node_arena_alloc(NodeArena* arena);
+void node_arena_free(NodeArena* arena, void* slot);
+size_t node_arena_bytes(size_t slot_size, size_t capacity);
+void* node_arena_alloc_run(NodeArena* arena, size_t count, size_t* taken);
+
+// Address of the slot with an index
+static inline void* node_arena_slot(const NodeArena* arena, uint32_t index) {
+    return (char*)(arena + 1) + (size_t)index * arena->slot_size;
+}
+
+// Index of a slot of the arena
+static inline uint32_t node_arena_index(const NodeArena* arena, const void* slot) {
+    return (uint32_t)(((const char*)slot - (const char*)(arena + 1)) / arena->slot_size);
+}
+
+// Whether a pointer is a slot of the arena
+static inline bool node_arena_owns(const NodeArena* arena, const void* ptr) {
+    const char* start = (const char*)(arena + 1);
+    return (const char*)ptr >= start && (const char*)ptr < start + (size_t)arena->capacity * arena->slot_size;
+}
+
+#endif
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include "memory_manager.h"
+#include "rcu_list.h"
+#include "epoch.h"
+#include "list_writer.h"
+
+static inline Node* rcu_load(Node* const* link) {
+    return __atomic_load_n(link, __ATOMIC_ACQUIRE);
+}
+
+// Publish a link once everything it points to is initialized
+static inline void rcu_publish(Node** link, Node* node) {
+    __atomic_store_n(link, node, __ATOMIC_RELEASE);
+}
+
+static void rcu_node_free(void* node) {
+    mem_free_inline(node, sizeof(Node));
+}
+
+// Start a read-side section; false if the thread could not be registered
+bool rcu_read_lock(void) {
+    return epoch_enter();
+}
+
+void rcu_read_unlock(void) {
+    epoch_exit();
+}
+
+// Start a traversal by a reader function: a read-side section, or, if the
+// thread cannot get an epoch record, the writer lock. Returns whether the
+// lock was taken.
+static bool rcu_reader_enter(const RcuList* list) {
+    if (rcu_read_lock()) {
+        return false;
+    }
+    pthread_mutex_lock((pthread_mutex_t*)&list->writer);
+    return true;
+}
+
+static void rcu_reader_exit(const RcuList* list, bool locked) {
+    if (locked) {
+        pthread_mutex_unlock((pthread_mutex_t*)&list->writer);
+    } else {
+        rcu_read_unlock();
+    }
+}
+
+// Create an empty list. The memory pool must already be set up.
+void rcu_list_init(RcuList* list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    pthread_mutex_init(&list->writer, NULL);
+}
+
+// Take a node from the pool, fully set up before anyone can see it
+static Node* rcu_new_node(uint16_t data, Node* next) {
+    Node* node = mem_alloc_inline(sizeof(Node));
+    if (node == NULL) {
+        printf("Memory allocation for new node failed.\n");
+        return NULL;
+    }
+    node->data = data;
+    node->next = next;
+    return node;
+}
+
+// Append a node; readers see it once the previous tail's link is stored
+bool rcu_list_insert(RcuList* list, uint16_t data) {
+    Node* node = rcu_new_node(data, NULL);
+    if (node == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&list->writer);
+    rcu_publish(list->tail != NULL ? &list->tail->next : &list->head, node);
+    list->tail = node;
+    __atomic_store_n(&list->length, list->length + 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&list->writer);
+    return true;
+}
+
+// Prepend a node
+bool rcu_list_insert_front(RcuList* list, uint16_t data) {
+    pthread_mutex_lock(&list->writer);
+    Node* node = rcu_new_node(data, list->head);
+    if (node != NULL) {
+        rcu_publish(&list->head, node);
+        if (list->tail == NULL) {
+            list->tail = node;
+        }
+        __atomic_store_n(&list->length, list->length + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&list->writer);
+    return node != NULL;
+}
+
+/**
+ * Delete the first node with the specified data.
+ *
+ * The node is unlinked with one store and keeps its own next pointer, so
+ * readers standing on it carry on along the list. It is freed after a grace
+ * period, by this thread.
+ *
+ * @return false if no node has the value.
+ */
+bool rcu_list_delete(RcuList* list, uint16_t data) {
+    pthread_mutex_lock(&list->writer);
+    Node** link = &list->head;
+    Node* prev = NULL;
+    while (*link != NULL && (*link)->data != data) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    Node* node = *link;
+    if (node != NULL) {
+        rcu_publish(link, node->next);
+        if (list->tail == node) {
+            list->tail = prev;
+        }
+        __atomic_store_n(&list->length, list->length - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&list->writer);
+    if (node == NULL) {
+        return false;
+    }
+    epoch_retire(node, rcu_node_free);
+    return true;
+}
+
+// Wait for a grace period and free the nodes this thread deleted before it.
+// Must not be called inside a read-side section.
+void rcu_list_synchronize(void) {
+    epoch_synchronize();
+}
+
+// Free the list. No reader may be using it any more.
+void rcu_list_destroy(RcuList* list) {
+    Node* node = list->head;
+    while (node != NULL) {
+        Node* next = node->next;
+        rcu_node_free(node);
+        node = next;
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    pthread_mutex_destroy(&list->writer);
+    epoch_synchronize();
+}
+
+// First node, for walks inside a read-side section
+Node* rcu_list_first(const RcuList* list) {
+    return rcu_load(&list->head);
+}
+
+// Node after node, for walks inside a read-side section
+Node* rcu_list_next(const Node* node) {
+    return rcu_load(&node->next);
+}
+
+// First node with the specified data, or NULL. The node stays valid only
+// while the caller holds a read-side section.
+Node* rcu_list_search(const RcuList* list, uint16_t data) {
+    bool locked = rcu_reader_enter(list);
+    Node* node = rcu_load(&list->head);
+    while (node != NULL && node->data != data) {
+        node = rcu_load(&node->next);
+    }
+    rcu_reader_exit(list, locked);
+    return node;
+}
+
+// Number of nodes one traversal sees
+size_t rcu_list_count(const RcuList* list) {
+    size_t count = 0;
+    bool locked = rcu_reader_enter(list);
+    for (Node* node = rcu_load(&list->head); node != NULL; node = rcu_load(&node->next)) {
+        count++;
+    }
+    rcu_reader_exit(list, locked);
+    return count;
+}
+
+// Display all nodes in the same format as list_display
+void rcu_list_display(const RcuList* list) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_writer_write(writer, "[", 1);
+    bool locked = rcu_reader_enter(list);
+    Node* first = rcu_load(&list->head);
+    for (Node* node = first; node != NULL; node = rcu_load(&node->next)) {
+        if (node != first) {
+            list_writer_write(writer, ", ", 2);
+        }
+        list_writer_u16(writer, node->data);
+    }
+    rcu_reader_exit(list, locked);
+    list_writer_write(writer, "]", 1);
+    list_writer_flush(writer);
+}
@@ -0,0 +1,41 @@
+#ifndef RCU_LIST_H
+#define RCU_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "linked_list.h"
+
+// Node list for read-mostly use: readers never lock and are never blocked by
+// the writer. Writers are serialized by a mutex and publish every change with
+// a single release store, so a reader sees each change entirely or not at
+// all. Unlinked nodes are freed through epoch-based reclamation (see epoch.h)
+// once every reader that could still be on them has left its section.
+typedef struct RcuList {
+    Node* head;                 // First node, NULL if the list is empty
+    Node* tail;                 // Last node; only used by the writer
+    size_t length;              // Number of nodes, updated by the writer
+    pthread_mutex_t writer;     // Held by the thread changing the list
+} RcuList;
+
+// Read-side sections. Reader functions enter one themselves; a caller that
+// keeps a Node* between calls must hold a section of its own for as long.
+bool rcu_read_lock(void);
+void rcu_read_unlock(void);
+
+void rcu_list_init(RcuList* list);
+bool rcu_list_insert(RcuList* list, uint16_t data);
+bool rcu_list_insert_front(RcuList* list, uint16_t data);
+bool rcu_list_delete(RcuList* list, uint16_t data);
+void rcu_list_synchronize(void);
+void rcu_list_destroy(RcuList* list);
+
+// Readers
+Node* rcu_list_first(const RcuList* list);
+Node* rcu_list_next(const Node* node);
+Node* rcu_list_search(const RcuList* list, uint16_t data);
+size_t rcu_list_count(const RcuList* list);
+void rcu_list_display(const RcuList* list);
+
+#endif
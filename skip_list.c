@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include "memory_manager.h"
+#include "skip_list.h"
+#include "list_writer.h"
+
+// Bytes of a node on height lanes
+static size_t skip_node_size(int height) {
+    return sizeof(SkipNode) + (size_t)(height - 1) * sizeof(SkipNode*);
+}
+
+// Next node on a lane; lane 0 is the plain Node link
+static inline SkipNode* skip_next(const SkipNode* node, int level) {
+    return level == 0 ? (SkipNode*)node->node.next : node->forward[level - 1];
+}
+
+static inline void skip_set_next(SkipNode* node, int level, SkipNode* next) {
+    if (level == 0) {
+        node->node.next = (Node*)next;
+    } else {
+        node->forward[level - 1] = next;
+    }
+}
+
+// Height of a new node: each lane above the first with probability 1/4
+static int skip_random_height(SkipList* list) {
+    uint32_t x = list->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    list->seed = x;
+    int height = 1 + __builtin_ctz(x | (1u << 31)) / 2;
+    return height < SKIP_MAX_LEVEL ? height : SKIP_MAX_LEVEL;
+}
+
+// Walk down the lanes to the last node on each lane before the first node
+// with a value >= data (or > data with after_equal), recording it in update
+static SkipNode* skip_find(const SkipList* list, uint16_t data, bool after_equal, SkipNode** update) {
+    SkipNode* node = list->head;
+    for (int level = list->level - 1; level >= 0; level--) {
+        SkipNode* next = skip_next(node, level);
+        while (next != NULL && (next->node.data < data || (after_equal && next->node.data == data))) {
+            node = next;
+            next = skip_next(node, level);
+        }
+        if (update != NULL) {
+            update[level] = node;
+        }
+    }
+    return skip_next(node, 0);
+}
+
+// Create an empty list. The memory pool must already be set up.
+bool skip_init(SkipList* list) {
+    list->head = mem_alloc(skip_node_size(SKIP_MAX_LEVEL));
+    list->level = 1;
+    list->length = 0;
+    list->seed = 0x9e3779b9u;
+    if (list->head == NULL) {
+        printf("Memory allocation for the skip list failed.\n");
+        return false;
+    }
+    list->head->node.data = 0;
+    list->head->height = SKIP_MAX_LEVEL;
+    for (int level = 0; level < SKIP_MAX_LEVEL; level++) {
+        skip_set_next(list->head, level, NULL);
+    }
+    return true;
+}
+
+// Insert a node in value order, after any nodes with the same value
+bool skip_insert(SkipList* list, uint16_t data) {
+    SkipNode* update[SKIP_MAX_LEVEL];
+    skip_find(list, data, true, update);
+
+    int height = skip_random_height(list);
+    SkipNode* node = mem_alloc_inline(skip_node_size(height));
+    if (node == NULL) {
+        printf("Memory allocation for new node failed.\n");
+        return false;
+    }
+    for (int level = list->level; level < height; level++) {
+        update[level] = list->head;
+    }
+    if (height > list->level) {
+        list->level = height;
+    }
+
+    node->node.data = data;
+    node->height = (uint8_t)height;
+    for (int level = 0; level < height; level++) {
+        skip_set_next(node, level, skip_next(update[level], level));
+        skip_set_next(update[level], level, node);
+    }
+    list->length++;
+    return true;
+}
+
+// Delete the first node with the specified data; false if there is none
+bool skip_delete(SkipList* list, uint16_t data) {
+    SkipNode* update[SKIP_MAX_LEVEL];
+    SkipNode* node = skip_find(list, data, false, update);
+    if (node == NULL || node->node.data != data) {
+        return false;
+    }
+    // The first node with the value is also the first on each of its lanes
+    for (int level = 0; level < node->height; level++) {
+        skip_set_next(update[level], level, skip_next(node, level));
+    }
+    while (list->level > 1 && skip_next(list->head, list->level - 1) == NULL) {
+        list->level--;
+    }
+    list->length--;
+    mem_free_inline(node, skip_node_size(node->height));
+    return true;
+}
+
+// First node with the specified data, or NULL
+Node* skip_search(const SkipList* list, uint16_t data) {
+    SkipNode* node = skip_find(list, data, false, NULL);
+    return node != NULL && node->node.data == data ? &node->node : NULL;
+}
+
+// First node with a value >= data, or NULL
+Node* skip_lower_bound(const SkipList* list, uint16_t data) {
+    SkipNode* node = skip_find(list, data, false, NULL);
+    return node != NULL ? &node->node : NULL;
+}
+
+/**
+ * Iterate over the nodes with values in [low, high], in order.
+ *
+ * Finding the first node is O(log n); each node after it is one step along
+ * the bottom lane. Use with skip_range_next:
+ *
+ *     SkipRange range = skip_range(&list, 100, 200);
+ *     for (Node* node; (node = skip_range_next(&range)) != NULL;) { ... }
+ *
+ * @param list: List to iterate over.
+ * @param low: First value in the range.
+ * @param high: Last value in the range.
+ * @return Iterator, positioned before the first node of the range.
+ */
+SkipRange skip_range(const SkipList* list, uint16_t low, uint16_t high) {
+    SkipRange range = {low <= high ? skip_lower_bound(list, low) : NULL, high};
+    return range;
+}
+
+// Number of nodes in O(1)
+size_t skip_count(const SkipList* list) {
+    return list->length;
+}
+
+// Display the nodes with values in [low, high] in the same format as
+// list_display
+void skip_display_range(const SkipList* list, uint16_t low, uint16_t high) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_writer_write(writer, "[", 1);
+    SkipRange range = skip_range(list, low, high);
+    Node* first = range.next;
+    for (Node* node; (node = skip_range_next(&range)) != NULL;) {
+        if (node != first) {
+            list_writer_write(writer, ", ", 2);
+        }
+        list_writer_u16(writer, node->data);
+    }
+    list_writer_write(writer, "]", 1);
+    list_writer_flush(writer);
+}
+
+/**
+ * Start a cursor at the first node of a skip list:
+ *
+ *     SkipCursor cursor;
+ *     skip_cursor_init(&cursor, &list);
+ *     for (Node* node; (node = skip_cursor_next(&cursor)) != NULL;) { ... }
+ *
+ * The list must not change while the cursor is in use.
+ *
+ * @param cursor: Cursor to set up.
+ * @param list: List to iterate over.
+ */
+void skip_cursor_init(SkipCursor* cursor, const SkipList* list) {
+    cursor->current = skip_next(list->head, 0);
+    SkipNode* ahead = list->level > 1 ? skip_next(list->head, 1) : NULL;
+    for (int i = 0; i < LIST_PREFETCH_DISTANCE && ahead != NULL; i++) {
+        __builtin_prefetch(ahead);
+        __builtin_prefetch(ahead->node.next);
+        ahead = skip_next(ahead, 1);
+    }
+    __builtin_prefetch(ahead);
+    cursor->ahead = ahead;
+}
+
+/**
+ * Call a function for each node, in value order, prefetching ahead of it
+ * along the express lane.
+ *
+ * @param list: List to iterate over.
+ * @param visit: Function to call; it must not change the node's data or
+ *        the list, and returns false to stop.
+ * @param ctx: Passed to visit.
+ * @return Number of nodes visited, including one that stopped the traversal.
+ */
+size_t skip_foreach(const SkipList* list, ListVisit visit, void* ctx) {
+    SkipCursor cursor;
+    skip_cursor_init(&cursor, list);
+    size_t visited = 0;
+    for (Node* node; (node = skip_cursor_next(&cursor)) != NULL;) {
+        visited++;
+        if (!visit(node, ctx)) {
+            break;
+        }
+    }
+    return visited;
+}
+
+// Free all nodes and the sentinel
+void skip_cleanup(SkipList* list) {
+    SkipNode* node = skip_next(list->head, 0);
+    while (node != NULL) {
+        SkipNode* next = skip_next(node, 0);
+        mem_free_inline(node, skip_node_size(node->height));
+        node = next;
+    }
+    mem_free(list->head);
+    list->head = NULL;
+    list->level = 1;
+    list->length = 0;
+}
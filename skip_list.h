@@ -0,0 +1,87 @@
+#ifndef SKIP_LIST_H
+#define SKIP_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "linked_list.h"
+
+// Most lanes a node can have; enough for lists of billions of nodes
+#define SKIP_MAX_LEVEL 16
+
+// Node of a skip list. It starts with a plain Node whose next pointer is the
+// bottom lane, so the nodes in value order form an ordinary Node list.
+typedef struct SkipNode {
+    Node node;                  // Data and the next node in value order
+    uint8_t height;             // Lanes the node is on, 1 to SKIP_MAX_LEVEL
+    struct SkipNode* forward[]; // Next node on lanes 1 to height - 1
+} SkipNode;
+
+// List kept sorted by value, with O(log n) expected insert, search and
+// delete. Each node is on lane 0 and, with probability 1/4 per lane, on the
+// express lanes above. &list->head->node.next can be passed to the Node**
+// functions that do not change the list (search, display, count).
+typedef struct SkipList {
+    SkipNode* head;     // Sentinel on every lane; head->node.next is the first node
+    int level;          // Lanes in use
+    size_t length;      // Number of nodes
+    uint32_t seed;      // Random state for node heights
+} SkipList;
+
+// Nodes with values in [low, high], in order (see skip_range)
+typedef struct SkipRange {
+    Node* next;         // Next node to return, NULL when done
+    uint16_t high;      // Last value in the range
+} SkipRange;
+
+// Iterator over all nodes in value order (see skip_cursor_init). The express
+// lane above the bottom one serves as jump pointers: a second pointer runs
+// LIST_PREFETCH_DISTANCE nodes ahead on it, each about four nodes apart, and
+// prefetches the nodes it lands on and the ones after them.
+typedef struct SkipCursor {
+    SkipNode* current;  // Node the next call returns, NULL at the end
+    SkipNode* ahead;    // Express-lane node being prefetched, NULL past the end
+} SkipCursor;
+
+bool skip_init(SkipList* list);
+bool skip_insert(SkipList* list, uint16_t data);
+bool skip_delete(SkipList* list, uint16_t data);
+Node* skip_search(const SkipList* list, uint16_t data);
+Node* skip_lower_bound(const SkipList* list, uint16_t data);
+SkipRange skip_range(const SkipList* list, uint16_t low, uint16_t high);
+size_t skip_count(const SkipList* list);
+void skip_display_range(const SkipList* list, uint16_t low, uint16_t high);
+void skip_cleanup(SkipList* list);
+void skip_cursor_init(SkipCursor* cursor, const SkipList* list);
+size_t skip_foreach(const SkipList* list, ListVisit visit, void* ctx);
+
+// Next node of a range, or NULL once it is past the range's end
+static inline Node* skip_range_next(SkipRange* range) {
+    Node* node = range->next;
+    if (node == NULL || node->data > range->high) {
+        range->next = NULL;
+        return NULL;
+    }
+    range->next = node->next;
+    return node;
+}
+
+// Next node of a cursor, or NULL at the end of the list
+static inline Node* skip_cursor_next(SkipCursor* cursor) {
+    SkipNode* node = cursor->current;
+    if (node == NULL) {
+        return NULL;
+    }
+    cursor->current = (SkipNode*)node->node.next;
+    if (node->height > 1 && cursor->ahead != NULL) {
+        // Passing an express-lane node: move the prefetch pointer on by one
+        // express hop. The node it leaves was prefetched a hop ago.
+        SkipNode* passed = cursor->ahead;
+        cursor->ahead = passed->forward[0];
+        __builtin_prefetch(passed->node.next);
+        __builtin_prefetch(cursor->ahead);
+    }
+    return &node->node;
+}
+
+#endif
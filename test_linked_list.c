@@ -1,9 +1,23 @@
 #include "linked_list.h"
+#include "unrolled_list.h"
+#include "compact_list.h"
+#include "doubly_list.h"
+#include "skip_list.h"
+#include "lockfree_list.h"
+#include "rcu_list.h"
+#include "epoch.h"
+#include "list_parallel.h"
+#include "memory_manager.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <time.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include "common_defs.h"
 #include "gitdata.h"
@@ -54,6 +68,29 @@ void test_list_init()
     list_init(&head, sizeof(Node));
     my_assert(head == NULL);
     list_cleanup(&head);
+
+    // A second list goes into the same pool, and the nodes of both stay valid
+    Node *first = NULL;
+    Node *second = NULL;
+    list_init(&first, sizeof(Node) * 4);
+    void *pool = mem_from_offset(0);
+    for (int i = 0; i < 4; i++)
+    {
+        list_insert(&first, i);
+    }
+    list_init(&second, sizeof(Node) * 4);
+    my_assert(mem_from_offset(0) == pool);
+    for (int i = 0; i < 4; i++)
+    {
+        list_insert(&second, 10 + i);
+    }
+    my_assert(second->next == second + 1 && mem_offset(first) != MEM_NULL_OFFSET);
+    list_delete(&first, 2);
+    list_delete(&second, 12);
+    my_assert(list_count_nodes(&first) == 3 && first->next->next->data == 3);
+    my_assert(list_count_nodes(&second) == 3 && second->next->next->data == 13);
+    list_cleanup(&first);
+    list_cleanup(&second);
     printf_green("[PASS].\n");
 }
 
@@ -132,6 +169,17 @@ void test_list_search()
     printf_green("[PASS].\n");
 }
 
+// Expected display of values[from..to]: "[a, b, c]"
+static void format_values(char *out, const int *values, int from, int to)
+{
+    out += sprintf(out, "[");
+    for (int k = from; k <= to; k++)
+    {
+        out += sprintf(out, k < to ? "%d, " : "%d", values[k]);
+    }
+    sprintf(out, "]");
+}
+
 void test_list_display()
 {
     printf_yellow("  Testing list_display ... \n");
@@ -164,130 +212,45 @@ void test_list_display()
     char *string1third = malloc(1024);
     char *stringRandom = malloc(1024);
 
-    sprintf(stringFull, "[");
-    sprintf(string2Last, "[");
-
     Node *Low = NULL;
     Node *High = NULL;
-    char LowValue[10];
-    char HighValue[10];
 
     int values[Nnodes];
-    for (int i = 0; i < Nnodes; i++)
-    {
-        values[i] = 0;
-    }
     for (int k = 0; k < Nnodes; k++)
     {
         values[k] = 10 + rand() % 90;
         list_insert(&head, values[k]);
-        if (k == randomLow && !Low)
-        {
-            Low = list_search(&head, values[k]);
-            sprintf(LowValue, "%d", values[k]);
-        }
-        if (k == randomHigh && !High)
-        {
-            High = list_search(&head, values[k]);
-            sprintf(HighValue, "%d", values[k]);
-        }
-        sprintf(stringFull + strlen(stringFull), "%d", values[k]);
-        if (k < (Nnodes - 1))
-        {
-            sprintf(stringFull + strlen(stringFull), ", ");
-        }
-        else
-        {
-            sprintf(stringFull + strlen(stringFull), "]");
-        }
     }
+    Low = list_search(&head, values[randomLow]);
+    High = list_search(&head, values[randomHigh]);
 
-#ifdef DEBUG
-    printf("LowValue=%s, HighValue=%s\n", LowValue, HighValue);
-    printf("RefFull:'%s'\n", stringFull);
-#endif
-
-    // [N0, N1, ...., NL]
-    sprintf(string2Last + 1, "%s", strchr(stringFull, ',') + 2);
-
-    //    printf("ref2Last: '%s\n", string2Last);
-
-    // [N0, N1, ...., NL]
-    char *Third = stringFull;
-    for (int i = 0; i < 3; i++)
+    // list_search finds the first node with a value, which for repeated
+    // values is not necessarily the node at randomLow or randomHigh
+    int lowIndex = 0;
+    while (values[lowIndex] != values[randomLow])
     {
-        Third = strchr(Third, ',');
-        Third += 1;
+        lowIndex++;
     }
-    int LenToThird = ((Third - stringFull));
-
-    strncpy(string1third, stringFull, LenToThird - 1);
-    sprintf(string1third + strlen(string1third), "]");
-
-    // printf("ref1third: '%s\n", string1third);
-
-    char *start = 0;
-    char *first = 0;
-    char *last = 0;
-
-    // Find first random node.
-    start = strstr(stringFull, LowValue);
-    first = strstr(stringFull, HighValue);
-    if (strlen(first) > 3)
+    int highIndex = 0;
+    while (values[highIndex] != values[randomHigh])
     {
-        // We have atleast one number after us.
-#ifdef DEBUG
-        printf("Last isnt last.\n");
-#endif
-        last = strstr(first, " ");
+        highIndex++;
     }
-    else
+    // A range whose end comes before its start runs to the end of the list
+    if (highIndex < lowIndex)
     {
-        // We are the last number.
-#ifdef DEBUG
-        printf("Last was last.\n");
-#endif
-        last = strstr(first, "]");
+        highIndex = Nnodes - 1;
     }
 
-    ptrdiff_t LenToFirst = ((char *)start - (char *)stringFull);
-    ptrdiff_t LenToLast = ((char *)last - (char *)stringFull);
-
-#ifdef DEBUG
-    printf("random starts at %p (offset=%ld) and ends at %p (offset=%ld).\n", start, LenToFirst, last, LenToLast);
-    printf("random: '%s' \n", start);
-
-#endif
-
-    char *blob = malloc(1024);
-    strncpy(blob, start, LenToLast - LenToFirst);
+    format_values(stringFull, values, 0, Nnodes - 1);
+    format_values(string2Last, values, 1, Nnodes - 1);
+    format_values(string1third, values, 0, 2);
+    format_values(stringRandom, values, lowIndex, highIndex);
 
-    sprintf(stringRandom, "[%s", blob);
-    if (!strchr(stringRandom, ']'))
-    {
-        sprintf(stringRandom + strlen(stringRandom), "]");
-    }
-    if (strstr(stringRandom, ",]"))
-    {
-        // Solution change ",]" to "]\0";
-        char *ptr = strstr(stringRandom, ",]");
-        sprintf(ptr, "]");
-        memset(ptr + 1, 0, 1);
 #ifdef DEBUG
-        printf("We have a problem Huston.\n");
-        printf("Fixed ,] issue.\n");
-        a
-#endif
-    }
-
-    if (strstr(stringRandom, ", ]"))
-    {
-#ifdef DEBUG
-        printf("We have a problem Huston2.\n");
+    printf("RefFull:'%s'\n", stringFull);
+    printf("RefRandom: '%s' \n\n", stringRandom);
 #endif
-    }
-
-    //    printf("RefRandom: '%s' \n\n", stringRandom);
 
     char buffer[1024] = {0}; // Buffer to capture the output
 
@@ -320,6 +283,10 @@ void test_list_display()
     my_assert(strcmp(buffer, stringRandom) == 0);
     printf("\tK random node(s): %s\n", buffer);
 
+    free(stringFull);
+    free(string2Last);
+    free(string1third);
+    free(stringRandom);
     list_cleanup(&head);
     printf_green("  ... [PASS].\n");
 }
@@ -479,6 +446,1393 @@ void test_list_edge_cases()
     printf_green("[PASS].\n");
 }
 
+void test_list_snapshot_restore(int count)
+{
+    printf_yellow("  Testing list restore from a pool snapshot ---> ");
+    char path[64];
+    sprintf(path, "/tmp/list_snapshot_%d", (int)getpid());
+
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_insert(&head, i);
+    }
+    mem_set_root(head);
+    my_assert(mem_snapshot(path));
+    void *old_pool = mem_from_offset(0);
+    mem_deinit();
+
+    // Occupy the old address so the restored pool has to move
+    long page = sysconf(_SC_PAGESIZE);
+    void *old_page = (void *)((uintptr_t)old_pool & ~(uintptr_t)(page - 1));
+    void *blocker = mmap(old_page, page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    my_assert(mem_restore(path));
+    head = mem_get_root();
+    my_assert(head != NULL);
+    if (blocker == old_page)
+    {
+        my_assert(mem_relocation_delta() != 0);
+    }
+    list_relocate(&head, mem_relocation_delta());
+
+    my_assert(list_count_nodes(&head) == count);
+    Node *current = head;
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(current->data == i);
+        current = current->next;
+    }
+
+    list_cleanup(&head);
+    mem_deinit();
+    if (blocker != MAP_FAILED)
+    {
+        munmap(blocker, page);
+    }
+    unlink(path);
+    printf_green("[PASS].\n");
+}
+
+// Checks that the descriptor's tail and length agree with its nodes
+void check_descriptor(const List *list)
+{
+    size_t length = 0;
+    Node *last = NULL;
+    for (Node *current = list->head; current != NULL; current = current->next)
+    {
+        last = current;
+        length++;
+    }
+    my_assert(list_length(list) == length && list->tail == last);
+}
+
+void test_list_descriptor(int count)
+{
+    printf_yellow("  Testing list descriptor ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+    check_descriptor(&list);
+
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(list_push_back(&list, i));
+    }
+    check_descriptor(&list);
+    my_assert(list.head->data == 0 && list.tail->data == count - 1);
+    my_assert(list_count_nodes(&list.head) == count);
+
+    // Updates at either end keep the tail right
+    my_assert(list_push_front(&list, 5000));
+    my_assert(list_insert_after_node(&list, list.tail, 5001));
+    my_assert(list.tail->data == 5001);
+    my_assert(list_insert_before_node(&list, list.tail, 5002));
+    my_assert(list_remove(&list, 5001));
+    my_assert(list.tail->data == 5002);
+    my_assert(list_remove(&list, 5000) && list.head->data == 0);
+    my_assert(!list_remove(&list, 5001));
+    my_assert(list_find(&list, count / 2)->data == count / 2);
+    my_assert(list_find(&list, 5001) == NULL);
+    check_descriptor(&list);
+
+    for (int i = count - 1; i >= 0; i--)
+    {
+        my_assert(list_remove(&list, i));
+    }
+    my_assert(list_remove(&list, 5002));
+    my_assert(list.head == NULL && list.tail == NULL && list_length(&list) == 0);
+
+    // Lists built with the Node** API can be adopted
+    Node *head = NULL;
+    list_insert(&head, 1);
+    list_insert(&head, 2);
+    list_adopt(&list, head);
+    check_descriptor(&list);
+    my_assert(list_push_back(&list, 3) && list_length(&list) == 3);
+
+    list_destroy(&list);
+    check_descriptor(&list);
+    printf_green("[PASS].\n");
+}
+
+// Checks an unrolled list's chunks and values against an array holding the same values
+void check_unrolled(const UnrolledList *list, const uint16_t *model, size_t length)
+{
+    size_t seen = 0;
+    const UnrolledChunk *last = NULL;
+    for (const UnrolledChunk *chunk = list->head; chunk != NULL; chunk = chunk->next)
+    {
+        my_assert(chunk->count > 0 && chunk->count <= UNROLLED_CAPACITY);
+        for (int i = 0; i < chunk->count; i++)
+        {
+            my_assert(seen < length && chunk->data[i] == model[seen]);
+            seen++;
+        }
+        last = chunk;
+    }
+    my_assert(seen == length && ulist_count(list) == length && list->tail == last);
+}
+
+void test_unrolled_list(int count)
+{
+    printf_yellow("  Testing unrolled list ---> ");
+    mem_init(1 << 20);
+    UnrolledList list;
+    ulist_init(&list);
+    uint16_t *model = malloc(2 * count * sizeof(uint16_t));
+    size_t length = 0;
+
+    // Appends fill chunks completely
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(ulist_insert(&list, i));
+        model[length++] = i;
+    }
+    check_unrolled(&list, model, length);
+    my_assert(list.head->count == UNROLLED_CAPACITY);
+
+    // Random inserts split chunks, random deletes borrow and merge
+    for (int i = 0; i < count; i++)
+    {
+        size_t index = rand() % (length + 1);
+        uint16_t value = count + i;
+        my_assert(ulist_insert_at(&list, index, value));
+        memmove(model + index + 1, model + index, (length - index) * sizeof(uint16_t));
+        model[index] = value;
+        length++;
+    }
+    check_unrolled(&list, model, length);
+    for (int i = 0; i < count + count / 2; i++)
+    {
+        size_t index = rand() % length;
+        uint16_t value = model[index];
+        size_t found;
+        my_assert(ulist_search(&list, value, &found) && found == index);
+        my_assert(ulist_delete(&list, value));
+        memmove(model + index, model + index + 1, (length - index - 1) * sizeof(uint16_t));
+        length--;
+    }
+    check_unrolled(&list, model, length);
+
+    uint16_t value;
+    my_assert(ulist_get(&list, length - 1, &value) && value == model[length - 1]);
+    my_assert(!ulist_get(&list, length, &value));
+    my_assert(!ulist_search(&list, 2 * count + 1, NULL));
+    my_assert(!ulist_insert_at(&list, length + 1, 1));
+
+    // Deleting everything frees every chunk
+    while (length > 0)
+    {
+        my_assert(ulist_delete(&list, model[--length]));
+    }
+    my_assert(list.head == NULL && list.tail == NULL);
+    ulist_cleanup(&list);
+    free(model);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_unrolled_simd(int count)
+{
+    printf_yellow("  Testing SIMD scans of the unrolled list ---> ");
+    mem_init(1 << 20);
+    UlistSimd levels[] = {ULIST_SIMD_SCALAR, ULIST_SIMD_SSE2, ULIST_SIMD_AVX2, ULIST_SIMD_AUTO};
+    uint16_t *model = malloc(count * sizeof(uint16_t));
+
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+    {
+        if (!ulist_set_simd(levels[l]))
+        {
+            continue; // Not supported by this CPU
+        }
+
+        // Few distinct values, so matches land in every lane position
+        UnrolledList list;
+        ulist_init(&list);
+        for (int i = 0; i < count; i++)
+        {
+            model[i] = rand() % 50;
+            ulist_insert(&list, model[i]);
+        }
+        size_t length = count;
+
+        for (uint16_t value = 0; value <= 50; value++)
+        {
+            size_t first = 0, matches = 0;
+            while (first < length && model[first] != value)
+            {
+                first++;
+            }
+            for (size_t i = 0; i < length; i++)
+            {
+                matches += model[i] == value;
+            }
+            size_t index;
+            my_assert(ulist_search(&list, value, &index) == (first < length));
+            my_assert(first == length || index == first);
+            my_assert(ulist_count_value(&list, value) == matches);
+        }
+
+        // Delete-first-match removes the same element the model does
+        for (int i = 0; i < count / 2; i++)
+        {
+            uint16_t value = model[rand() % length];
+            size_t first = 0;
+            while (model[first] != value)
+            {
+                first++;
+            }
+            my_assert(ulist_delete(&list, value));
+            memmove(model + first, model + first + 1, (length - first - 1) * sizeof(uint16_t));
+            length--;
+        }
+        check_unrolled(&list, model, length);
+        ulist_cleanup(&list);
+    }
+
+    free(model);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Node at a position of a list
+Node *node_at(const List *list, size_t position)
+{
+    Node *current = list->head;
+    while (position-- > 0)
+    {
+        current = current->next;
+    }
+    return current;
+}
+
+// Checks that an indexed list finds the first occurrence of every value
+void check_value_index(const List *list)
+{
+    check_descriptor(list);
+    for (int value = 0; value < 64; value++)
+    {
+        Node *first = list->head;
+        while (first != NULL && first->data != value)
+        {
+            first = first->next;
+        }
+        my_assert(list_find(list, value) == first);
+    }
+}
+
+void test_list_value_index(int count)
+{
+    printf_yellow("  Testing the list value index ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+    for (int i = 0; i < count / 2; i++)
+    {
+        list_push_back(&list, rand() % 64);
+    }
+    my_assert(list_index_enable(&list));
+    check_value_index(&list);
+
+    // Every kind of update, with plenty of duplicate values
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t value = rand() % 64;
+        switch (rand() % 5)
+        {
+        case 0:
+            my_assert(list_push_back(&list, value));
+            break;
+        case 1:
+            my_assert(list_push_front(&list, value));
+            break;
+        case 2:
+            my_assert(list_length(&list) == 0 || list_insert_after_node(&list, node_at(&list, rand() % list_length(&list)), value));
+            break;
+        case 3:
+            my_assert(list_length(&list) == 0 || list_insert_before_node(&list, node_at(&list, rand() % list_length(&list)), value));
+            break;
+        default:
+            list_remove(&list, value);
+            break;
+        }
+        if (i % 100 == 0)
+        {
+            check_value_index(&list);
+        }
+    }
+    check_value_index(&list);
+
+    // Dropping and rebuilding gives the same answers
+    list_index_disable(&list);
+    my_assert(list.index == NULL);
+    check_value_index(&list);
+    my_assert(list_index_enable(&list));
+    check_value_index(&list);
+
+    // Emptying the list through the index
+    while (list.head != NULL)
+    {
+        my_assert(list_remove(&list, list.tail->data));
+    }
+    check_value_index(&list);
+    list_destroy(&list);
+    my_assert(list.index == NULL);
+    printf_green("[PASS].\n");
+}
+
+void test_list_node_arena(int count)
+{
+    printf_yellow("  Testing the list node arena ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+
+    // Nodes come from one array, in order
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(list_push_back(&list, i));
+    }
+    for (Node *current = list.head; current->next != NULL; current = current->next)
+    {
+        my_assert((char *)current->next - (char *)current == sizeof(Node));
+    }
+
+    // A freed node is the next one handed out
+    Node *middle = list_find(&list, count / 2);
+    my_assert(list_remove(&list, count / 2));
+    my_assert(list_push_back(&list, 7777) && list.tail == middle);
+
+    // Beyond the capacity nodes come from the pool
+    my_assert(list_push_back(&list, 8888));
+    my_assert(list.tail != NULL && list.tail->data == 8888);
+    my_assert(list_remove(&list, 8888));
+    check_descriptor(&list);
+
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_compact_list(int count)
+{
+    printf_yellow("  Testing the compact list ---> ");
+    mem_init(1 << 20);
+    my_assert(sizeof(CompactNode) == 8);
+    CompactList list;
+    my_assert(clist_init(&list, count));
+
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(clist_push_back(&list, i));
+    }
+    my_assert(!clist_push_back(&list, 1)); // Full
+    my_assert(clist_count(&list) == (size_t)count);
+
+    uint32_t found = clist_find(&list, count / 2);
+    my_assert(found != NODE_ARENA_NONE && clist_node(&list, found)->data == count / 2);
+    my_assert(clist_remove(&list, 0) && clist_remove(&list, count - 1) && !clist_remove(&list, count));
+    my_assert(clist_push_front(&list, 5000) && clist_insert_after(&list, list.tail, 5001));
+    my_assert(clist_node(&list, list.head)->data == 5000 && clist_node(&list, list.tail)->data == 5001);
+    my_assert(clist_find(&list, 0) == NODE_ARENA_NONE);
+
+    // Index links stay valid when the arena is copied elsewhere
+    size_t bytes = node_arena_bytes(sizeof(CompactNode), count);
+    CompactList copy = list;
+    copy.arena = mem_alloc(bytes);
+    memcpy(copy.arena, list.arena, bytes);
+    size_t length = 0;
+    uint32_t a = list.head, b = copy.head;
+    while (a != NODE_ARENA_NONE)
+    {
+        my_assert(b == a && clist_node(&copy, b)->data == clist_node(&list, a)->data);
+        a = clist_node(&list, a)->next;
+        b = clist_node(&copy, b)->next;
+        length++;
+    }
+    my_assert(b == NODE_ARENA_NONE && length == clist_count(&copy));
+    mem_free(copy.arena);
+
+    clist_destroy(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Read back everything written to a temporary file, as a string
+static char *read_back(FILE *fp)
+{
+    fflush(fp);
+    long size = lseek(fileno(fp), 0, SEEK_END);
+    char *text = malloc(size + 1);
+    my_assert(pread(fileno(fp), text, size, 0) == size);
+    text[size] = '\0';
+    return text;
+}
+
+// Leaves output in its thread's shared writer without flushing it
+static void *write_unflushed(void *arg)
+{
+    ListWriter *writer = list_writer_shared();
+    my_assert(writer != NULL);
+    list_writer_init(writer, fileno((FILE *)arg));
+    list_writer_u16(writer, 42);
+    return writer;
+}
+
+void test_list_writer(int count)
+{
+    printf_yellow("  Testing the buffered list writer ---> ");
+    static const uint16_t edges[] = {0, 9, 10, 99, 100, 999, 1000, 9999, 10000, 65535};
+    size_t edge_count = sizeof(edges) / sizeof(edges[0]);
+    List list;
+    list_create(&list, sizeof(Node) * count);
+
+    // Reference text from printf; long enough to span several buffers
+    char *expected = malloc((size_t)count * 8 + 3);
+    char *end = expected + sprintf(expected, "[");
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t value = i < (int)edge_count ? edges[i] : (uint16_t)(i * 7919);
+        my_assert(list_push_back(&list, value));
+        end += sprintf(end, i + 1 < count ? "%d, " : "%d", value);
+    }
+    sprintf(end, "]");
+    my_assert(strlen(expected) > 2 * LIST_WRITER_BUFFER);
+
+    // Whole list to a file descriptor
+    FILE *fp = tmpfile();
+    my_assert(list_dump(&list.head, fileno(fp)));
+    char *text = read_back(fp);
+    my_assert(strcmp(text, expected) == 0);
+    free(text);
+    fclose(fp);
+
+    // A range to a stream, in order with other output on it
+    fp = tmpfile();
+    ListWriter *writer = list_writer_shared();
+    my_assert(writer != NULL && list_writer_shared() == writer);
+    list_writer_init_file(writer, fp);
+    fprintf(fp, "<");
+    my_assert(list_write(writer, list.head->next, list.head->next->next->next));
+    my_assert(list_writer_flush(writer));
+    fprintf(fp, ">");
+    text = read_back(fp);
+    my_assert(strcmp(text, "<[9, 10, 99]>") == 0);
+    free(text);
+
+    // Writes larger than the buffer bypass it and keep their order
+    list_writer_init_file(writer, fp);
+    rewind(fp);
+    my_assert(ftruncate(fileno(fp), 0) == 0);
+    list_writer_write(writer, "x", 1);
+    my_assert(list_writer_write(writer, expected, strlen(expected)));
+    list_writer_write(writer, "y", 1);
+    my_assert(list_writer_flush(writer));
+    text = read_back(fp);
+    my_assert(text[0] == 'x' && strncmp(text + 1, expected, strlen(expected)) == 0);
+    my_assert(strcmp(text + 1 + strlen(expected), "y") == 0);
+    free(text);
+    fclose(fp);
+
+    // Another thread gets its own writer, flushed when the thread exits
+    fp = tmpfile();
+    pthread_t tid;
+    pthread_create(&tid, NULL, write_unflushed, fp);
+    pthread_join(tid, NULL);
+    text = read_back(fp);
+    my_assert(strcmp(text, "42") == 0);
+    free(text);
+    fclose(fp);
+
+    // Failed writes are reported
+    list_writer_init(writer, -1);
+    list_writer_u16(writer, 1);
+    my_assert(!list_writer_flush(writer));
+
+    free(expected);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Check a doubly linked list's links in both directions against its length
+static void check_doubly(const DList *list)
+{
+    size_t forward = 0;
+    const DNode *prev = NULL;
+    for (const DNode *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(node->prev == prev);
+        prev = node;
+        forward++;
+    }
+    my_assert(list->tail == prev && forward == dlist_count(list));
+}
+
+void test_doubly_list(int count)
+{
+    printf_yellow("  Testing the doubly linked list ---> ");
+    mem_init(1 << 20);
+    DList list;
+    dlist_init(&list);
+
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(dlist_insert(&list, i));
+    }
+    check_doubly(&list);
+    my_assert(dlist_count(&list) == (size_t)count);
+
+    // Insert before and delete nodes the caller holds, including at the ends
+    DNode *middle = dlist_search(&list, count / 2);
+    my_assert(dlist_insert_before(&list, middle, 60000));
+    my_assert(middle->prev->data == 60000 && middle->prev->prev->data == count / 2 - 1);
+    my_assert(dlist_insert_before(&list, list.head, 60001) && list.head->data == 60001);
+    my_assert(dlist_insert_after(&list, list.tail, 60002) && list.tail->data == 60002);
+    my_assert(dlist_insert_front(&list, 60003) && list.head->data == 60003);
+    check_doubly(&list);
+    my_assert(dlist_count(&list) == (size_t)count + 4);
+
+    dlist_delete_node(&list, middle->prev);
+    dlist_delete_node(&list, list.head);
+    dlist_delete_node(&list, list.tail);
+    my_assert(middle->prev->data == count / 2 - 1);
+    my_assert(list.head->data == 60001);
+    check_doubly(&list);
+    my_assert(dlist_delete(&list, 60001) && !dlist_delete(&list, 60001));
+    my_assert(list.head->data == 0 && list.tail->data == count - 1);
+
+    // Reverse traversal finds the last occurrence
+    my_assert(dlist_insert(&list, 7));
+    my_assert(dlist_search_last(&list, 7) == list.tail && dlist_search(&list, 7) != list.tail);
+    dlist_delete_node(&list, list.tail);
+
+    // Deleting every node one by one leaves an empty list
+    while (list.head != NULL)
+    {
+        dlist_delete_node(&list, list.length % 2 ? list.head : list.tail);
+        check_doubly(&list);
+    }
+    my_assert(list.tail == NULL && dlist_count(&list) == 0);
+
+    dlist_cleanup(&list);
+    mem_tcache_flush();
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Check that a skip list is sorted on every lane and its lanes skip only
+// nodes of lower height
+static void check_skip(const SkipList *list)
+{
+    size_t length = 0;
+    for (const Node *node = list->head->node.next; node != NULL; node = node->next)
+    {
+        my_assert(node->next == NULL || node->data <= node->next->data);
+        length++;
+    }
+    my_assert(length == skip_count(list));
+    for (int level = 1; level < list->level; level++)
+    {
+        const SkipNode *lane = list->head->forward[level - 1];
+        const SkipNode *node = (const SkipNode *)list->head->node.next;
+        for (; node != NULL; node = (const SkipNode *)node->node.next)
+        {
+            if (node->height > level)
+            {
+                my_assert(node == lane);
+                lane = lane->forward[level - 1];
+            }
+        }
+        my_assert(lane == NULL);
+    }
+}
+
+void test_skip_list(int count)
+{
+    printf_yellow("  Testing the skip list ---> ");
+    mem_init(1 << 20);
+    SkipList list;
+    my_assert(skip_init(&list));
+
+    // Random values, with duplicates; counts[] is the reference
+    static int counts[UINT16_MAX + 1];
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t value = rand() % 1000;
+        my_assert(skip_insert(&list, value));
+        counts[value]++;
+    }
+    check_skip(&list);
+    my_assert(list.level > 1);
+
+    for (int value = 0; value < 1000; value++)
+    {
+        Node *found = skip_search(&list, value);
+        my_assert((found != NULL) == (counts[value] > 0));
+        my_assert(found == NULL || found->data == value);
+    }
+
+    // Range scans see exactly the values in range, in order
+    uint16_t low = 100 + rand() % 400;
+    uint16_t high = low + rand() % 300;
+    size_t expected = 0;
+    for (int value = low; value <= high; value++)
+    {
+        expected += counts[value];
+    }
+    SkipRange range = skip_range(&list, low, high);
+    size_t seen = 0;
+    uint16_t previous = low;
+    for (Node *node; (node = skip_range_next(&range)) != NULL;)
+    {
+        my_assert(node->data >= previous && node->data <= high);
+        previous = node->data;
+        seen++;
+    }
+    my_assert(seen == expected);
+    range = skip_range(&list, high, low);
+    my_assert(skip_range_next(&range) == NULL || high == low);
+    range = skip_range(&list, 1000, UINT16_MAX);
+    my_assert(skip_range_next(&range) == NULL);
+
+    // Deleting removes one node per call, until the value is gone
+    for (int value = 0; value < 1000; value += 3)
+    {
+        while (counts[value] > 0)
+        {
+            my_assert(skip_delete(&list, value));
+            counts[value]--;
+        }
+        my_assert(!skip_delete(&list, value) && !skip_search(&list, value));
+    }
+    check_skip(&list);
+
+    // Range display, in the same format as list_display_range
+    skip_cleanup(&list);
+    my_assert(skip_init(&list));
+    for (int value = 0; value < 10; value++)
+    {
+        my_assert(skip_insert(&list, 9 - value));
+    }
+    char buffer[64] = {0};
+    fflush(stdout);
+    FILE *original_stdout = stdout;
+    stdout = tmpfile();
+    skip_display_range(&list, 3, 6);
+    fflush(stdout);
+    rewind(stdout);
+    my_assert(fread(buffer, 1, sizeof(buffer) - 1, stdout) > 0);
+    fclose(stdout);
+    stdout = original_stdout;
+    my_assert(strcmp(buffer, "[3, 4, 5, 6]") == 0);
+    my_assert(list_count_nodes(&list.head->node.next) == 10);
+
+    // Deleting every node, in random order, keeps the lanes consistent
+    for (int value = 0; value < 10; value++)
+    {
+        my_assert(skip_delete(&list, (value * 7) % 10));
+        my_assert(!skip_search(&list, (value * 7) % 10));
+        check_skip(&list);
+    }
+    my_assert(!skip_delete(&list, 0) && skip_count(&list) == 0 && list.level == 1);
+
+    skip_cleanup(&list);
+    mem_tcache_flush();
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+typedef struct LfWorker
+{
+    LfList *list;
+    int id;
+    int threads;
+    int count;
+} LfWorker;
+
+// Inserts the values v with v % threads == id, deletes every other one, and
+// searches the whole range meanwhile
+static void *lf_worker(void *arg)
+{
+    LfWorker *worker = arg;
+    for (int v = worker->id; v < worker->count; v += worker->threads)
+    {
+        my_assert(lf_insert(worker->list, v));
+        my_assert(!lf_insert(worker->list, v));
+        my_assert(lf_contains(worker->list, v));
+    }
+    for (int v = worker->id; v < worker->count; v += 2 * worker->threads)
+    {
+        my_assert(lf_delete(worker->list, v));
+        my_assert(!lf_delete(worker->list, v));
+        lf_contains(worker->list, rand() % worker->count);
+    }
+    return NULL;
+}
+
+static int reclaimed = 0;
+static void count_reclaim(void *ptr)
+{
+    (void)ptr;
+    __atomic_add_fetch(&reclaimed, 1, __ATOMIC_SEQ_CST);
+}
+
+static int reader_state = 0; // 1: inside a section, 2: told to leave
+
+// Leaves its section when told to, unless arg is set: then it exits inside it
+static void *epoch_reader(void *arg)
+{
+    my_assert(epoch_enter());
+    __atomic_store_n(&reader_state, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&reader_state, __ATOMIC_SEQ_CST) != 2)
+    {
+        sched_yield();
+    }
+    if (arg == NULL)
+    {
+        epoch_exit();
+    }
+    return NULL;
+}
+
+void test_lockfree_list(int threads, int count)
+{
+    printf_yellow("  Testing the lock-free list with %d threads ---> ", threads);
+    mem_init(1 << 20);
+
+    // A retired block outlives every reader that was inside when it was retired
+    pthread_t reader;
+    reader_state = 0;
+    reclaimed = 0;
+    pthread_create(&reader, NULL, epoch_reader, NULL);
+    while (__atomic_load_n(&reader_state, __ATOMIC_SEQ_CST) != 1)
+    {
+        sched_yield();
+    }
+    for (int i = 0; i < 4 * EPOCH_BATCH; i++)
+    {
+        epoch_retire(NULL, count_reclaim);
+    }
+    my_assert(reclaimed == 0 && epoch_pending() == 4 * EPOCH_BATCH);
+    __atomic_store_n(&reader_state, 2, __ATOMIC_SEQ_CST);
+    pthread_join(reader, NULL);
+    epoch_synchronize();
+    my_assert(reclaimed == 4 * EPOCH_BATCH && epoch_pending() == 0);
+
+    // A reader that exits inside its section neither hangs nor holds the epoch back
+    reader_state = 0;
+    pthread_create(&reader, NULL, epoch_reader, &reader_state);
+    while (__atomic_load_n(&reader_state, __ATOMIC_SEQ_CST) != 1)
+    {
+        sched_yield();
+    }
+    epoch_retire(NULL, count_reclaim);
+    __atomic_store_n(&reader_state, 2, __ATOMIC_SEQ_CST);
+    pthread_join(reader, NULL);
+    epoch_synchronize();
+    my_assert(reclaimed == 4 * EPOCH_BATCH + 1 && epoch_pending() == 0);
+
+    // Concurrent inserts, deletes and searches
+    LfList list;
+    my_assert(lf_init(&list));
+    pthread_t tids[threads];
+    LfWorker workers[threads];
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t] = (LfWorker){&list, t, threads, count};
+        pthread_create(&tids[t], NULL, lf_worker, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(tids[t], NULL);
+    }
+
+    // Left: the values whose index within their thread's share is odd
+    size_t expected = 0;
+    for (int v = 0; v < count; v++)
+    {
+        bool kept = (v / threads) % 2 == 1;
+        expected += kept;
+        my_assert(lf_contains(&list, v) == kept);
+    }
+    my_assert(lf_count(&list) == expected);
+    uint16_t previous = 0;
+    for (LfNode *node = (LfNode *)list.head->next; node != NULL; node = (LfNode *)node->next)
+    {
+        my_assert((node->next & 1) == 0 && node->data >= previous);
+        previous = node->data;
+    }
+
+    lf_destroy(&list);
+    my_assert(epoch_pending() == 0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+typedef struct RcuReader
+{
+    RcuList *list;
+    int stop;
+    size_t reads;
+} RcuReader;
+
+// Values 0..99 are never deleted, so every traversal must find them; the
+// writer keeps at most 100 other values in the list
+static void *rcu_reader(void *arg)
+{
+    RcuReader *reader = arg;
+    unsigned seed = (unsigned)(size_t)&reader;
+    while (!__atomic_load_n(&reader->stop, __ATOMIC_ACQUIRE))
+    {
+        uint16_t value = rand_r(&seed) % 100;
+        Node *node = rcu_list_search(reader->list, value);
+        my_assert(node != NULL);
+        size_t count = rcu_list_count(reader->list);
+        my_assert(count >= 100 && count <= 200);
+        reader->reads++;
+        sched_yield();
+    }
+    return NULL;
+}
+
+static int rcu_holder_state = 0; // 1: holding a node, 2: told to let go
+static Node *rcu_held = NULL;
+
+static void *rcu_holder(void *arg)
+{
+    RcuList *list = arg;
+    my_assert(rcu_read_lock());
+    rcu_held = rcu_list_search(list, 5000);
+    __atomic_store_n(&rcu_holder_state, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&rcu_holder_state, __ATOMIC_SEQ_CST) != 2)
+    {
+        sched_yield();
+    }
+    // Still intact, with its link to the rest of the list
+    my_assert(rcu_held->data == 5000 && rcu_list_next(rcu_held) != NULL);
+    rcu_read_unlock();
+    return NULL;
+}
+
+static int rcu_records_taken = 0; // Threads holding or failing to get an epoch record
+static int rcu_records_release = 0;
+
+static void *rcu_record_taker(void *arg)
+{
+    (void)arg;
+    bool entered = rcu_read_lock();
+    __atomic_fetch_add(&rcu_records_taken, 1, __ATOMIC_SEQ_CST);
+    while (entered && !__atomic_load_n(&rcu_records_release, __ATOMIC_SEQ_CST))
+    {
+        sched_yield();
+    }
+    if (entered)
+    {
+        rcu_read_unlock();
+    }
+    return NULL;
+}
+
+// Runs with every epoch record taken: readers must still see the whole list
+static void *rcu_unregistered_reader(void *arg)
+{
+    RcuList *list = arg;
+    my_assert(!rcu_read_lock());
+    rcu_read_unlock(); // Unbalanced, must not leave the thread's depth below zero
+    my_assert(rcu_list_count(list) == 100 && rcu_list_search(list, 99) != NULL);
+    return NULL;
+}
+
+void test_rcu_list(int readers, int updates)
+{
+    printf_yellow("  Testing RCU reads with %d readers ---> ", readers);
+    mem_init(1 << 20);
+    RcuList list;
+    rcu_list_init(&list);
+    for (int v = 0; v < 100; v++)
+    {
+        my_assert(rcu_list_insert(&list, v));
+    }
+
+    // One writer inserting and deleting while readers search and count
+    pthread_t tids[readers];
+    RcuReader state[readers];
+    for (int t = 0; t < readers; t++)
+    {
+        state[t] = (RcuReader){&list, 0, 0};
+        pthread_create(&tids[t], NULL, rcu_reader, &state[t]);
+    }
+    for (int i = 0; i < updates; i++)
+    {
+        uint16_t value = 1000 + i % 100;
+        if (i % 200 < 100)
+        {
+            my_assert(i % 2 ? rcu_list_insert(&list, value) : rcu_list_insert_front(&list, value));
+        }
+        else
+        {
+            my_assert(rcu_list_delete(&list, value));
+        }
+    }
+    for (int t = 0; t < readers; t++)
+    {
+        __atomic_store_n(&state[t].stop, 1, __ATOMIC_RELEASE);
+        pthread_join(tids[t], NULL);
+        my_assert(state[t].reads > 0);
+    }
+    my_assert(rcu_list_count(&list) == 100 && list.length == 100);
+    my_assert(rcu_list_search(&list, 1000) == NULL && list.tail->data == 99);
+
+    // A deleted node outlives the reader standing on it
+    rcu_list_synchronize();
+    my_assert(epoch_pending() == 0);
+    my_assert(rcu_list_insert_front(&list, 5000));
+    pthread_t holder;
+    rcu_holder_state = 0;
+    pthread_create(&holder, NULL, rcu_holder, &list);
+    while (__atomic_load_n(&rcu_holder_state, __ATOMIC_SEQ_CST) != 1)
+    {
+        sched_yield();
+    }
+    my_assert(rcu_list_delete(&list, 5000) && rcu_list_search(&list, 5000) == NULL);
+    for (int i = 0; i < 4 * EPOCH_BATCH; i++)
+    {
+        my_assert(rcu_list_insert(&list, 6000));
+        my_assert(rcu_list_delete(&list, 6000));
+    }
+    my_assert(epoch_pending() > 0);
+    __atomic_store_n(&rcu_holder_state, 2, __ATOMIC_SEQ_CST);
+    pthread_join(holder, NULL);
+    rcu_list_synchronize();
+    my_assert(epoch_pending() == 0);
+
+    // Readers fall back to the writer lock once no epoch record is left
+    pthread_t takers[EPOCH_MAX_THREADS];
+    rcu_records_taken = 0;
+    rcu_records_release = 0;
+    for (int t = 0; t < EPOCH_MAX_THREADS; t++)
+    {
+        pthread_create(&takers[t], NULL, rcu_record_taker, NULL);
+    }
+    while (__atomic_load_n(&rcu_records_taken, __ATOMIC_SEQ_CST) != EPOCH_MAX_THREADS)
+    {
+        sched_yield();
+    }
+    pthread_t reader;
+    pthread_create(&reader, NULL, rcu_unregistered_reader, &list);
+    pthread_join(reader, NULL);
+    __atomic_store_n(&rcu_records_release, 1, __ATOMIC_SEQ_CST);
+    for (int t = 0; t < EPOCH_MAX_THREADS; t++)
+    {
+        pthread_join(takers[t], NULL);
+    }
+
+    rcu_list_destroy(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Sorts a copy of values with one of the list sorts and checks the result is
+// sorted, stable (nodes come from the arena in insertion order, so equal
+// values must keep ascending addresses) and holds the same values
+static void check_sort(void (*sort)(Node **), const uint16_t *values, int count)
+{
+    static size_t histogram[UINT16_MAX + 1];
+    memset(histogram, 0, sizeof(histogram));
+    List list;
+    list_create(&list, sizeof(Node) * (count + 1));
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(list_push_back(&list, values[i]));
+        histogram[values[i]]++;
+    }
+    my_assert(list_index_enable(&list));
+
+    sort(&list.head);
+    list_adopt(&list, list.head);
+
+    my_assert(list_length(&list) == (size_t)count);
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        histogram[node->data]--;
+        if (node->next != NULL)
+        {
+            my_assert(node->data <= node->next->data);
+            my_assert(node->data != node->next->data || node < node->next);
+        }
+    }
+    for (int v = 0; v <= UINT16_MAX; v++)
+    {
+        my_assert(histogram[v] == 0);
+    }
+    if (count > 0)
+    {
+        my_assert(list.tail->next == NULL && list_find(&list, values[0]) != NULL);
+        my_assert(list_push_back(&list, UINT16_MAX) && list.tail->data == UINT16_MAX);
+    }
+    list_destroy(&list);
+}
+
+void test_list_sort(int count)
+{
+    printf_yellow("  Testing list_sort and list_sort_radix ---> ");
+    uint16_t *values = malloc(sizeof(uint16_t) * count);
+    void (*sorts[])(Node **) = {list_sort, list_sort_radix};
+    for (int s = 0; s < 2; s++)
+    {
+        check_sort(sorts[s], values, 0);
+        values[0] = 7;
+        check_sort(sorts[s], values, 1);
+
+        for (int i = 0; i < count; i++)
+        {
+            values[i] = rand() % 100; // Many duplicates
+        }
+        check_sort(sorts[s], values, count);
+        for (int i = 0; i < count; i++)
+        {
+            values[i] = rand() % (UINT16_MAX + 1);
+        }
+        check_sort(sorts[s], values, count);
+        for (int i = 0; i < count; i++)
+        {
+            values[i] = count - i; // Descending
+        }
+        check_sort(sorts[s], values, count);
+        for (int i = 0; i < count; i++)
+        {
+            values[i] = (i % 3) << 8; // Low bytes all equal
+        }
+        check_sort(sorts[s], values, count);
+    }
+    free(values);
+    printf_green("[PASS].\n");
+}
+
+// Number of hops to a node at a lower address, i.e. backwards in memory
+static size_t backward_hops(const List *list)
+{
+    size_t hops = 0;
+    for (const Node *node = list->head; node != NULL && node->next != NULL; node = node->next)
+    {
+        hops += node->next < node;
+    }
+    return hops;
+}
+
+void test_list_compact(int count)
+{
+    printf_yellow("  Testing list_compact ---> ");
+    // Arena for most of the nodes; the rest come from the pool
+    List list;
+    list_create(&list, sizeof(Node) * (count - count / 8));
+
+    // Scatter the list: every value goes after a random earlier node
+    Node **nodes = malloc(sizeof(Node *) * count);
+    my_assert(list_push_back(&list, 0));
+    nodes[0] = list.head;
+    for (int i = 1; i < count; i++)
+    {
+        Node *prev = nodes[rand() % i];
+        my_assert(list_insert_after_node(&list, prev, i));
+        nodes[i] = prev->next;
+    }
+    for (int i = 0; i < count; i += 3)
+    {
+        my_assert(list_remove(&list, i));
+    }
+    uint16_t *expected = malloc(sizeof(uint16_t) * count);
+    size_t length = 0;
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        expected[length++] = node->data;
+    }
+    my_assert(length == list_length(&list) && backward_hops(&list) > length / 4);
+    my_assert(list_index_enable(&list));
+
+    // A length that is out of date leaves the list as it is
+    Node *head = list.head;
+    list_insert_after(list.tail, 0); // 0 was removed above
+    my_assert(!list_compact(&list) && list.head == head);
+    list_delete(&list.head, 0);
+    list_delete(&list.head, expected[1]);
+    my_assert(!list_compact(&list) && list.head == head);
+    list_adopt(&list, list.head);
+    memmove(expected + 1, expected + 2, (length - 2) * sizeof(uint16_t));
+    length--;
+    my_assert(list_length(&list) == length);
+
+    // Same values in the same order, now in one run of consecutive nodes
+    my_assert(list_compact(&list));
+    size_t i = 0;
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        my_assert(i < length && node->data == expected[i]);
+        my_assert(node->next == NULL || node->next == node + 1);
+        i++;
+    }
+    my_assert(i == length && list_length(&list) == length && list.tail->data == expected[length - 1]);
+    my_assert(backward_hops(&list) == 0 && list.index != NULL);
+    my_assert(list_find(&list, expected[length / 2]) != NULL && list_remove(&list, expected[length / 2]));
+
+    free(expected);
+    free(nodes);
+    list_destroy(&list);
+
+    // An empty list stays empty
+    list_create(&list, sizeof(Node) * 4);
+    my_assert(list_compact(&list) && list.head == NULL && list_length(&list) == 0);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Appends each visited value to a buffer; stops after limit values
+typedef struct VisitLog
+{
+    uint16_t *values;
+    size_t count;
+    size_t limit;
+} VisitLog;
+
+static bool log_visit(Node *node, void *ctx)
+{
+    VisitLog *log = ctx;
+    log->values[log->count++] = node->data;
+    return log->count < log->limit;
+}
+
+void test_list_foreach(int count)
+{
+    printf_yellow("  Testing list_foreach and list cursors ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+    uint16_t *values = malloc(sizeof(uint16_t) * count);
+    VisitLog log = {values, 0, SIZE_MAX};
+
+    // Empty lists: nothing is visited
+    my_assert(list_foreach(&list.head, log_visit, &log) == 0 && log.count == 0);
+    ListCursor cursor;
+    list_cursor_init(&cursor, list.head);
+    my_assert(list_cursor_next(&cursor) == NULL);
+
+    // Lists shorter and longer than the prefetch distance
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(list_push_back(&list, rand() % 1000));
+        if (i == LIST_PREFETCH_DISTANCE / 2 || i == count - 1)
+        {
+            log.count = 0;
+            my_assert(list_foreach(&list.head, log_visit, &log) == list_length(&list));
+            size_t n = 0;
+            list_cursor_init(&cursor, list.head);
+            for (Node *node = list.head; node != NULL; node = node->next)
+            {
+                my_assert(list_cursor_next(&cursor) == node && values[n++] == node->data);
+            }
+            my_assert(n == log.count && list_cursor_next(&cursor) == NULL);
+        }
+    }
+
+    // The visit function can stop the walk
+    log.count = 0;
+    log.limit = count / 3;
+    my_assert(list_foreach(&list.head, log_visit, &log) == (size_t)count / 3);
+    list_destroy(&list);
+
+    // The skip cursor returns the bottom lane in value order
+    mem_init(1 << 20);
+    SkipList skip;
+    my_assert(skip_init(&skip));
+    log.count = 0;
+    log.limit = SIZE_MAX;
+    my_assert(skip_foreach(&skip, log_visit, &log) == 0);
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(skip_insert(&skip, rand() % 1000));
+    }
+    my_assert(skip_foreach(&skip, log_visit, &log) == skip_count(&skip));
+    SkipCursor skip_cursor;
+    skip_cursor_init(&skip_cursor, &skip);
+    size_t n = 0;
+    for (Node *node = skip.head->node.next; node != NULL; node = node->next)
+    {
+        my_assert(skip_cursor_next(&skip_cursor) == node && values[n] == node->data);
+        my_assert(n == 0 || values[n - 1] <= values[n]);
+        n++;
+    }
+    my_assert(n == skip_count(&skip) && skip_cursor_next(&skip_cursor) == NULL);
+    skip_cleanup(&skip);
+    mem_deinit();
+    free(values);
+    printf_green("[PASS].\n");
+}
+
+// Segment starts must be list nodes in list order, the first at the head
+static void check_segments(const List *list)
+{
+    size_t segment = 0;
+    for (Node *node = list->head; node != NULL; node = node->next)
+    {
+        if (node == list_segment_start(list, segment))
+        {
+            segment++;
+        }
+    }
+    my_assert(segment == list_segment_count(list));
+    my_assert(list->head == NULL || list_segment_start(list, 0) == list->head);
+}
+
+static void count_task(size_t task, int worker, void *ctx)
+{
+    int *runs = ctx;
+    my_assert(worker >= 0 && worker < 4);
+    // Uneven tasks, so threads run out of their own share and steal
+    for (volatile size_t spin = 0; spin < (task % 7) * 1000; spin++)
+    {
+    }
+    __atomic_fetch_add(&runs[task], 1, __ATOMIC_RELAXED);
+}
+
+static bool is_even(uint16_t data, void *ctx)
+{
+    (void)ctx;
+    return data % 2 == 0;
+}
+
+void test_list_parallel(int count)
+{
+    printf_yellow("  Testing parallel list aggregates ---> ");
+    ThreadPool *pool = thread_pool_create(4);
+    my_assert(pool != NULL && thread_pool_size(pool) == 4);
+
+    // Every task runs exactly once
+    int *runs = calloc(count, sizeof(int));
+    thread_pool_run(pool, count, count_task, runs);
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(runs[i] == 1);
+    }
+    free(runs);
+
+    List list;
+    list_create(&list, sizeof(Node) * (count + 16));
+    uint16_t min, max;
+    uint64_t counts[16];
+    my_assert(list_parallel_sum(&list, pool) == 0 && !list_parallel_minmax(&list, pool, &min, &max));
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(list_push_back(&list, rand() % 60000 + 100));
+    }
+    my_assert(list_segment_count(&list) == (count + LIST_SEGMENT_NODES - 1) / LIST_SEGMENT_NODES);
+    check_segments(&list);
+
+    // Changes keep the directory valid: removing segment starts, inserting
+    // before them and at the head
+    for (size_t s = 1; s < list_segment_count(&list); s += 2)
+    {
+        my_assert(list_insert_before_node(&list, list_segment_start(&list, s), 7));
+        my_assert(list_remove(&list, list_segment_start(&list, s)->data));
+    }
+    my_assert(list_remove(&list, list.head->data) && list_push_front(&list, 65000));
+    check_segments(&list);
+
+    uint64_t sum = 0;
+    size_t even = 0;
+    uint16_t low = UINT16_MAX, high = 0;
+    uint64_t expected[16] = {0};
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        sum += node->data;
+        even += node->data % 2 == 0;
+        low = node->data < low ? node->data : low;
+        high = node->data > high ? node->data : high;
+        expected[node->data >> 12]++;
+    }
+    my_assert(list_parallel_sum(&list, pool) == sum && list_parallel_sum(&list, NULL) == sum);
+    my_assert(list_parallel_minmax(&list, pool, &min, &max) && min == low && max == high);
+    my_assert(list_parallel_histogram(&list, pool, counts, 16) && memcmp(counts, expected, sizeof(counts)) == 0);
+    my_assert(!list_parallel_histogram(&list, pool, counts, 0));
+    my_assert(list_parallel_count_if(&list, pool, is_even, NULL) == even);
+
+    // Removing everything leaves no segments
+    while (list.head != NULL)
+    {
+        my_assert(list_remove(&list, list.head->data));
+    }
+    my_assert(list_segment_count(&list) == 0 && list_parallel_sum(&list, pool) == 0);
+    list_destroy(&list);
+    thread_pool_destroy(pool);
+    printf_green("[PASS].\n");
+}
+
+// The list's values, in order, must equal values[0..count)
+static void check_values(const List *list, const uint16_t *values, size_t count)
+{
+    size_t i = 0;
+    for (Node *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(i < count && node->data == values[i]);
+        i++;
+    }
+    my_assert(i == count && list_length(list) == count);
+    my_assert(count == 0 ? list->tail == NULL : list->tail->data == values[count - 1]);
+}
+
+void test_list_bulk(int count)
+{
+    printf_yellow("  Testing bulk list conversions ---> ");
+    uint16_t *values = malloc(sizeof(uint16_t) * count * 2);
+    uint16_t *exported = malloc(sizeof(uint16_t) * count * 2);
+    for (int i = 0; i < count * 2; i++)
+    {
+        values[i] = rand() % UINT16_MAX;
+    }
+
+    // One contiguous run of nodes
+    List list;
+    my_assert(list_from_array(&list, values, count));
+    check_values(&list, values, count);
+    for (Node *node = list.head; node->next != NULL; node = node->next)
+    {
+        my_assert(node->next == node + 1);
+    }
+    my_assert(list_to_array(&list, exported, count * 2) == (size_t)count);
+    my_assert(memcmp(exported, values, sizeof(uint16_t) * count) == 0);
+    my_assert(list_to_array(&list, exported, 13) == 13 && memcmp(exported, values, sizeof(uint16_t) * 13) == 0);
+
+    // Break the run up so export mixes gathered and single nodes, then
+    // append past the arena's capacity with an index and segments
+    my_assert(list_index_enable(&list) && list_segments_enable(&list));
+    for (int i = 0; i < count; i += 37)
+    {
+        my_assert(list_remove(&list, values[i]));
+    }
+    my_assert(list_insert_bulk(&list, values + count, count / 8) && list_insert_bulk(&list, values, 0));
+    size_t length = 0;
+    for (Node *node = list.head; node != NULL; node = node->next)
+    {
+        values[length++] = node->data;
+    }
+    check_values(&list, values, length);
+    check_segments(&list);
+    my_assert(list_to_array(&list, exported, count * 2) == length);
+    my_assert(memcmp(exported, values, sizeof(uint16_t) * length) == 0);
+    for (size_t i = length - count / 8; i < length; i += 11)
+    {
+        Node *found = list_find(&list, values[i]);
+        my_assert(found != NULL && found->data == values[i]);
+    }
+    list_destroy(&list);
+
+    // Empty arrays and lists
+    my_assert(list_from_array(&list, values, 0));
+    check_values(&list, values, 0);
+    my_assert(list_to_array(&list, exported, count) == 0);
+    list_destroy(&list);
+    free(values);
+    free(exported);
+    printf_green("[PASS].\n");
+}
+
 // Main function to run all tests
 int main(int argc, char *argv[])
 {
@@ -509,6 +1863,25 @@ int main(int argc, char *argv[])
         printf(" 12. test_list_delete_loop - Test multiple detelions\n");
         printf(" 13. test_list_search_loop - Test multiple search\n");
         printf(" 14. test_list_edge_cases - Test edge cases\n");
+
+        printf("\nPersistence and Variants:\n");
+        printf(" 15. test_list_snapshot_restore - Test restoring a list from a pool snapshot\n");
+        printf(" 16. test_list_descriptor - Test the list descriptor with O(1) append and length\n");
+        printf(" 17. test_unrolled_list - Test the unrolled list against an array model\n");
+        printf(" 18. test_unrolled_simd - Test SIMD search, count and delete on the unrolled list\n");
+        printf(" 19. test_list_value_index - Test O(1) search and delete through the value index\n");
+        printf(" 20. test_list_node_arena - Test nodes preallocated by list_init\n");
+        printf(" 21. test_compact_list - Test the list with 32-bit index links\n");
+        printf(" 22. test_list_writer - Test streaming list output through a buffered writer\n");
+        printf(" 23. test_doubly_list - Test the doubly linked list\n");
+        printf(" 24. test_skip_list - Test the sorted skip list and range queries\n");
+        printf(" 25. test_lockfree_list - Test the lock-free list and epoch-based reclamation\n");
+        printf(" 26. test_rcu_list - Test RCU-style reads under a concurrent writer\n");
+        printf(" 27. test_list_sort - Test merge and radix sorting of lists\n");
+        printf(" 28. test_list_compact - Test relaying a list out in traversal order\n");
+        printf(" 29. test_list_foreach - Test list_foreach, skip_foreach and the prefetching cursors\n");
+        printf(" 30. test_list_parallel - Test the segment directory, thread pool and parallel aggregates\n");
+        printf(" 31. test_list_bulk - Test list_from_array, list_insert_bulk and list_to_array\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -536,6 +1909,25 @@ int main(int argc, char *argv[])
         test_list_delete_loop(1000);
         test_list_search_loop(1000);
         test_list_edge_cases();
+
+        printf("\nTesting Persistence and Variants:\n");
+        test_list_snapshot_restore(1000);
+        test_list_descriptor(1000);
+        test_unrolled_list(2000);
+        test_unrolled_simd(3000);
+        test_list_value_index(2000);
+        test_list_node_arena(1000);
+        test_compact_list(1000);
+        test_list_writer(20000);
+        test_doubly_list(1000);
+        test_skip_list(3000);
+        test_lockfree_list(4, 2000);
+        test_rcu_list(3, 20000);
+        test_list_sort(5000);
+        test_list_compact(4000);
+        test_list_foreach(3000);
+        test_list_parallel(50000);
+        test_list_bulk(5000);
         break;
     case 1:
         test_list_init();
@@ -580,6 +1972,57 @@ int main(int argc, char *argv[])
     case 14:
         test_list_edge_cases();
         break;
+    case 15:
+        test_list_snapshot_restore(1000);
+        break;
+    case 16:
+        test_list_descriptor(1000);
+        break;
+    case 17:
+        test_unrolled_list(2000);
+        break;
+    case 18:
+        test_unrolled_simd(3000);
+        break;
+    case 19:
+        test_list_value_index(2000);
+        break;
+    case 20:
+        test_list_node_arena(1000);
+        break;
+    case 21:
+        test_compact_list(1000);
+        break;
+    case 22:
+        test_list_writer(20000);
+        break;
+    case 23:
+        test_doubly_list(1000);
+        break;
+    case 24:
+        test_skip_list(3000);
+        break;
+    case 25:
+        test_lockfree_list(4, 2000);
+        break;
+    case 26:
+        test_rcu_list(3, 20000);
+        break;
+    case 27:
+        test_list_sort(5000);
+        break;
+    case 28:
+        test_list_compact(4000);
+        break;
+    case 29:
+        test_list_foreach(3000);
+        break;
+    case 30:
+        test_list_parallel(50000);
+        break;
+    case 31:
+        test_list_bulk(5000);
+        break;
 
     default:
         printf("Invalid test function\n");
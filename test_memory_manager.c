@@ -4,6 +4,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
 #include "common_defs.h"
 
 #include "gitdata.h"
@@ -162,7 +168,16 @@ void test_exact_fit_reuse()
     void *block2 = mem_alloc(500); // Reuse the exact space freed
     my_assert(block1 == block2);   // Should be the same address if reused properly
 
+    // Headers live outside the pool, so even a one-granule leftover is split
+    // off as a block of its own rather than handed to the caller
     mem_free(block2);
+    void *most = mem_alloc(1024 - sizeof(size_t));
+    my_assert(most != NULL && mem_used() == 1024 - sizeof(size_t));
+    void *last = mem_alloc(sizeof(size_t));
+    my_assert(last != NULL && mem_used() == 1024);
+
+    mem_free(most);
+    mem_free(last);
     mem_deinit();
     printf_green("[PASS].\n");
 }
@@ -324,6 +339,595 @@ void test_edge_case_allocations()
     printf_green("[PASS].\n");
 }
 
+void test_shared_pool()
+{
+    printf_yellow("  Testing shared memory pool across processes ---> ");
+    char name[64];
+    sprintf(name, "/mm_test_%d", (int)getpid());
+
+    my_assert(mem_init_shared(name, 4096));
+    char *parent_block = mem_alloc(100);
+    my_assert(parent_block != NULL);
+    strcpy(parent_block, "parent");
+    size_t parent_offset = mem_offset(parent_block);
+
+    int fds[2];
+    my_assert(pipe(fds) == 0);
+    pid_t pid = fork();
+    my_assert(pid >= 0);
+    if (pid == 0)
+    {
+        // Attach by name, like an unrelated process would, usually at another address
+        close(fds[0]);
+        if (!mem_init_shared(name, 0))
+            _exit(1);
+        char *child_block = mem_alloc(100);
+        if (child_block == NULL)
+            _exit(2);
+        strcpy(child_block, "from child");
+        char *seen = mem_from_offset(parent_offset);
+        if (seen == NULL || strcmp(seen, "parent") != 0)
+            _exit(3);
+        size_t offset = mem_offset(child_block);
+        if (write(fds[1], &offset, sizeof(offset)) != sizeof(offset))
+            _exit(4);
+        mem_deinit();
+        _exit(0);
+    }
+
+    close(fds[1]);
+    size_t offset = MEM_NULL_OFFSET;
+    my_assert(read(fds[0], &offset, sizeof(offset)) == sizeof(offset));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    my_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // The child's block is visible zero-copy and does not overlap ours
+    char *child_block = mem_from_offset(offset);
+    my_assert(child_block != NULL);
+    my_assert(strcmp(child_block, "from child") == 0);
+    my_assert(child_block >= parent_block + 100 || child_block + 100 <= parent_block);
+    my_assert(strcmp(parent_block, "parent") == 0);
+
+    // Blocks can be freed by any process sharing the pool
+    mem_free(child_block);
+    mem_free(parent_block);
+    void *whole = mem_alloc(4096);
+    my_assert(whole != NULL);
+
+    mem_free(whole);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_snapshot_restore()
+{
+    printf_yellow("  Testing mem_snapshot and mem_restore ---> ");
+    char path[64];
+    sprintf(path, "/tmp/mm_snapshot_%d", (int)getpid());
+
+    mem_init(4096);
+    char *block1 = mem_alloc(100);
+    char *block2 = mem_alloc(200);
+    my_assert(block1 != NULL && block2 != NULL);
+    strcpy(block1, "first");
+    strcpy(block2, "second");
+    mem_set_root(block2);
+    size_t offset1 = mem_offset(block1);
+    my_assert(mem_snapshot(path));
+
+    // Changes after the snapshot are lost on restore
+    strcpy(block1, "changed");
+    mem_deinit();
+
+    my_assert(mem_restore(path));
+    char *root = mem_get_root();
+    my_assert(root != NULL);
+    my_assert(strcmp(root, "second") == 0);
+    char *restored1 = mem_from_offset(offset1);
+    my_assert(strcmp(restored1, "first") == 0);
+
+    // The restored pool keeps allocating around the live blocks
+    char *block3 = mem_alloc(300);
+    my_assert(block3 != NULL);
+    my_assert(block3 >= root + 200);
+    mem_free(restored1);
+    mem_free(root);
+    mem_free(block3);
+    void *whole = mem_alloc(4096);
+    my_assert(whole != NULL);
+
+    mem_free(whole);
+    mem_deinit();
+
+    // Restoring over a live shared pool releases it and removes its name;
+    // a failed restore keeps the current pool
+    char name[64];
+    sprintf(name, "/mm_restore_%d", (int)getpid());
+    my_assert(mem_init_shared(name, 4096));
+    my_assert(mem_restore(path));
+    my_assert(shm_open(name, O_RDWR, 0) < 0 && errno == ENOENT);
+    root = mem_get_root();
+    my_assert(root != NULL && strcmp(root, "second") == 0);
+    my_assert(!mem_restore("/nonexistent/snapshot"));
+    my_assert(mem_get_root() == root && strcmp(root, "second") == 0);
+    mem_deinit();
+    unlink(path);
+    printf_green("[PASS].\n");
+}
+
+void *arena_worker(void *arg)
+{
+    unsigned char tag = (unsigned char)(size_t)arg;
+    unsigned char *blocks[4];
+    for (int round = 0; round < 200; round++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            blocks[i] = mem_alloc(16 + 8 * i);
+            if (blocks[i] == NULL)
+                return (void *)1;
+            memset(blocks[i], tag, 16 + 8 * i);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 16 + 8 * i; j++)
+            {
+                if (blocks[i][j] != tag)
+                    return (void *)1;
+            }
+            mem_free(blocks[i]);
+        }
+    }
+    return NULL;
+}
+
+void test_arenas(MemArenaMode mode)
+{
+    printf_yellow("  Testing %s arenas ---> ", mode == MEM_ARENA_PER_CPU ? "per-CPU" : "per-thread");
+    my_assert(mem_init_arenas(4 * 1024, mode, 4));
+
+    // Allocations spill over into other arenas rather than failing
+    void *blocks[4];
+    for (int i = 0; i < 4; i++)
+    {
+        blocks[i] = mem_alloc(1024);
+        my_assert(blocks[i] != NULL);
+    }
+    my_assert(mem_alloc(8) == NULL);
+    for (int i = 0; i < 4; i++)
+    {
+        mem_free(blocks[i]);
+    }
+
+    // More threads than arenas, each checking nobody else touched its blocks
+    pthread_t threads[16];
+    for (size_t t = 0; t < 16; t++)
+    {
+        my_assert(pthread_create(&threads[t], NULL, arena_worker, (void *)(t + 1)) == 0);
+    }
+    for (int t = 0; t < 16; t++)
+    {
+        void *result;
+        pthread_join(threads[t], &result);
+        my_assert(result == NULL);
+    }
+
+    // Everything was returned to the arena it came from
+    for (int i = 0; i < 4; i++)
+    {
+        blocks[i] = mem_alloc(1024);
+        my_assert(blocks[i] != NULL);
+    }
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_handles_and_compaction()
+{
+    printf_yellow("  Testing movable blocks and mem_compact ---> ");
+    mem_init(800); // Same layout as test_non_contiguous_allocation_failure
+
+    MemHandle handle1 = mem_halloc(250);
+    MemHandle handle2 = mem_halloc(250);
+    MemHandle handle3 = mem_halloc(250);
+    my_assert(handle1 != MEM_NULL_HANDLE && handle2 != MEM_NULL_HANDLE && handle3 != MEM_NULL_HANDLE);
+    char *data = mem_hlock(handle2);
+    my_assert(data != NULL);
+    for (int i = 0; i < 250; i++)
+    {
+        data[i] = (char)i;
+    }
+    mem_hunlock(handle2);
+    mem_hfree(handle1);
+    mem_hfree(handle3);
+    my_assert(mem_alloc(500) == NULL); // Fragmented
+
+    // A locked block is never moved
+    char *locked = mem_hlock(handle2);
+    my_assert(mem_compact((size_t)-1) == 0);
+    mem_hunlock(handle2);
+
+    // Compacting in small steps slides the block down and frees one large extent
+    size_t moved = 0;
+    size_t step;
+    while ((step = mem_compact(1)) > 0)
+    {
+        moved += step;
+    }
+    my_assert(moved == 256);
+    data = mem_hlock(handle2);
+    my_assert(data != locked);
+    for (int i = 0; i < 250; i++)
+    {
+        my_assert(data[i] == (char)i);
+    }
+    mem_hunlock(handle2);
+
+    void *block = mem_alloc(500);
+    my_assert(block != NULL);
+
+    // Blocks from mem_alloc are never moved, and movable blocks do not slide past them
+    mem_hfree(handle2);
+    mem_free(block);
+    MemHandle front = mem_halloc(16);
+    void *pinned = mem_alloc(16);
+    MemHandle back = mem_halloc(16);
+    mem_hfree(front);
+    my_assert(mem_compact((size_t)-1) == 0);
+    my_assert(mem_alloc(16) == (char *)pinned - 16);
+
+    mem_hfree(back);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_huge_allocations()
+{
+    printf_yellow("  Testing huge allocations through mmap ---> ");
+    mem_init(1024);
+    mem_set_mmap_threshold(4096);
+
+    // Served outside the pool, page aligned, without using any of it
+    size_t big_size = 1 << 20;
+    unsigned char *big = mem_alloc(big_size);
+    my_assert(big != NULL);
+    my_assert(((size_t)big & 4095) == 0);
+    memset(big, 0xab, big_size);
+    void *block = mem_alloc(1024);
+    my_assert(block != NULL);
+
+    // Grows by remapping and keeps the contents
+    big = mem_resize(big, 4 * big_size);
+    my_assert(big != NULL);
+    my_assert(big[0] == 0xab && big[big_size - 1] == 0xab);
+    big[4 * big_size - 1] = 1;
+
+    // Pool blocks that grow past the threshold move out of the pool
+    mem_free(block);
+    char *small = mem_alloc(100);
+    strcpy(small, "moved");
+    char *grown = mem_resize(small, 8192);
+    my_assert(grown != NULL && strcmp(grown, "moved") == 0);
+    my_assert(mem_alloc(1024) != NULL);
+
+    mem_free(big);
+    mem_free(big); // Double free is ignored
+    mem_free(grown);
+
+    // Threshold 0 keeps everything in the pool again
+    mem_set_mmap_threshold(0);
+    my_assert(mem_alloc(big_size) == NULL);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_calloc()
+{
+    printf_yellow("  Testing zero-initialized allocation ---> ");
+    mem_init(1 << 20);
+
+    // Overflowing element counts are rejected
+    my_assert(mem_calloc((size_t)-1, 16) == NULL);
+
+    // Memory that was used and freed comes back cleared
+    unsigned char *dirty = mem_alloc(4096);
+    memset(dirty, 0xcd, 4096);
+    mem_free(dirty);
+    unsigned char *clean = mem_calloc(512, 8);
+    my_assert(clean == dirty);
+    for (size_t i = 0; i < 4096; i++)
+    {
+        my_assert(clean[i] == 0);
+    }
+    mem_free(clean);
+
+    // Large blocks take the streaming path
+    size_t big_size = 600 * 1024;
+    unsigned char *big = mem_alloc(big_size);
+    memset(big, 0xef, big_size);
+    mem_free(big);
+    big = mem_calloc(big_size / 4, 4);
+    my_assert(big != NULL);
+    for (size_t i = 0; i < big_size; i++)
+    {
+        my_assert(big[i] == 0);
+    }
+    memset(big, 0x11, big_size);
+    mem_free(big);
+
+    // Trimmed pages read back as zero and stay zero through mem_calloc
+    my_assert(mem_trim() >= big_size - 2 * 4096);
+    big = mem_calloc(1, big_size);
+    for (size_t i = 0; i < big_size; i++)
+    {
+        my_assert(big[i] == 0);
+    }
+    mem_free(big);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void count_pressure(size_t used, size_t limit, void *context)
+{
+    my_assert(used > limit);
+    (*(int *)context)++;
+}
+
+// Gives a cached block back to the pool when asked to
+void drop_cache(size_t used, size_t limit, void *context)
+{
+    (void)used;
+    (void)limit;
+    void **cache = context;
+    mem_free(*cache);
+    *cache = NULL;
+}
+
+void *delayed_free(void *arg)
+{
+    usleep(50000);
+    mem_free(arg);
+    return NULL;
+}
+
+void test_alloc_wait_and_pressure()
+{
+    printf_yellow("  Testing blocking allocation and memory pressure ---> ");
+    mem_init(1024);
+
+    // Crossing the soft limit fires the callbacks once until usage drops back
+    int fired = 0;
+    my_assert(mem_add_pressure_callback(count_pressure, &fired));
+    mem_set_watermark(600);
+    void *base = mem_alloc(512);
+    my_assert(mem_used() == 512 && fired == 0);
+    void *over = mem_alloc(256);
+    my_assert(mem_used() == 768 && fired == 1);
+    void *more = mem_alloc(8);
+    my_assert(fired == 1);
+    mem_free(over);
+    mem_free(more);
+    my_assert(mem_used() == 512);
+    over = mem_alloc(256);
+    my_assert(fired == 2);
+    my_assert(mem_remove_pressure_callback(count_pressure, &fired));
+    my_assert(!mem_remove_pressure_callback(count_pressure, &fired));
+    mem_set_watermark(0);
+
+    // A full pool times out
+    void *rest = mem_alloc(256);
+    my_assert(rest != NULL && mem_alloc(8) == NULL);
+    my_assert(mem_alloc_wait(256, 20) == NULL);
+
+    // Requests that can never fit fail at once instead of waiting
+    my_assert(mem_alloc_wait(2048, -1) == NULL);
+
+    // A free from another thread wakes the waiter
+    pthread_t thread;
+    pthread_create(&thread, NULL, delayed_free, rest);
+    void *woken = mem_alloc_wait(256, -1);
+    my_assert(woken == rest);
+    pthread_join(thread, NULL);
+
+    // Pressure callbacks get a chance to free memory before the caller parks
+    void *cache = over;
+    my_assert(mem_add_pressure_callback(drop_cache, &cache));
+    void *reclaimed = mem_alloc_wait(256, 0);
+    my_assert(reclaimed == over && cache == NULL);
+    my_assert(mem_remove_pressure_callback(drop_cache, &cache));
+
+    mem_free(base);
+    mem_free(woken);
+    mem_free(reclaimed);
+    my_assert(mem_used() == 0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Bytes wasted rounding each sample up to its class
+size_t class_waste(const size_t *sizes, size_t n, const size_t *classes)
+{
+    size_t waste = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t c = 0;
+        while (classes[c] < sizes[i])
+        {
+            c++;
+        }
+        waste += classes[c] - sizes[i];
+    }
+    return waste;
+}
+
+void test_size_classes()
+{
+    printf_yellow("  Testing adaptive size classes ---> ");
+    size_t classes[MEM_MAX_SIZE_CLASSES];
+    size_t bad[] = {16, 8};
+    my_assert(!mem_set_size_classes(bad, 2));
+    my_assert(!mem_profile_sizes(10, MEM_MAX_SIZE_CLASSES + 1));
+
+    // Two classes for three equally common sizes: merging the two small ones wastes least
+    mem_init(4096);
+    my_assert(mem_profile_sizes(300, 2));
+    for (int i = 0; i < 100; i++)
+    {
+        mem_free(mem_alloc(20));
+        mem_free(mem_alloc(40));
+        mem_free(mem_alloc(200));
+    }
+    my_assert(mem_get_size_classes(classes, MEM_MAX_SIZE_CLASSES) == 2);
+    my_assert(classes[0] == 40 && classes[1] == 200);
+
+    // Requests round up to their class; larger ones keep their size
+    void *block = mem_alloc(30);
+    my_assert(mem_used() == 40);
+    mem_free(block);
+    block = mem_alloc(300);
+    my_assert(mem_used() == 304);
+    mem_free(block);
+
+    // The derived table matches the best one found by brute force
+    size_t sizes[1000];
+    unsigned seed = 42;
+    my_assert(mem_profile_sizes(1000, 4));
+    for (int i = 0; i < 1000; i++)
+    {
+        sizes[i] = 8 * (1 + rand_r(&seed) % 10);
+        mem_free(mem_alloc(sizes[i]));
+    }
+    my_assert(mem_get_size_classes(classes, MEM_MAX_SIZE_CLASSES) == 4);
+    size_t derived = class_waste(sizes, 1000, classes);
+    size_t best = (size_t)-1;
+    for (size_t a = 8; a < 80; a += 8)
+    {
+        for (size_t b = a + 8; b < 80; b += 8)
+        {
+            for (size_t c = b + 8; c < 80; c += 8)
+            {
+                size_t candidate[] = {a, b, c, 80};
+                size_t waste = class_waste(sizes, 1000, candidate);
+                best = waste < best ? waste : best;
+            }
+        }
+    }
+    my_assert(classes[3] == 80 && derived == best);
+    mem_deinit();
+
+    // Tables survive a round trip through a file and apply to the next pool
+    const char *path = "/tmp/test_size_classes.txt";
+    my_assert(mem_save_size_classes(path));
+    my_assert(mem_set_size_classes(NULL, 0));
+    my_assert(mem_get_size_classes(classes, MEM_MAX_SIZE_CLASSES) == 0);
+    my_assert(mem_load_size_classes(path));
+    my_assert(mem_get_size_classes(classes, MEM_MAX_SIZE_CLASSES) == 4 && classes[3] == 80);
+    unlink(path);
+
+    // A class too large for the free space falls back to the exact size
+    size_t large[] = {2048};
+    my_assert(mem_set_size_classes(large, 1));
+    mem_init(1024);
+    block = mem_alloc(8);
+    my_assert(block != NULL && mem_used() == 8);
+    mem_deinit();
+    my_assert(mem_set_size_classes(NULL, 0));
+
+    printf_green("[PASS].\n");
+}
+
+void *cached_worker(void *arg)
+{
+    (void)arg;
+    void *block = mem_alloc_inline(24);
+    my_assert(block != NULL);
+    mem_free_inline(block, 24);
+    return NULL; // The thread's cache goes back to the pool on exit
+}
+
+void test_inline_fast_path()
+{
+    printf_yellow("  Testing thread-cached inline allocation ---> ");
+    mem_init(4096);
+
+    // A miss takes a batch from the pool; a freed block is handed out next
+    void *first = mem_alloc_inline(16);
+    my_assert(first != NULL && mem_used() == 16 * MEM_TCACHE_BATCH);
+    mem_free_inline(first, 16);
+    void *again = mem_alloc_inline(16);
+    my_assert(again == first && mem_used() == 16 * MEM_TCACHE_BATCH);
+
+    // Sizes beyond the bins go straight to the pool
+    void *large = mem_alloc_inline(MEM_TCACHE_MAX + 8);
+    my_assert(mem_used() == 16 * MEM_TCACHE_BATCH + MEM_TCACHE_MAX + 8);
+    mem_free_inline(large, MEM_TCACHE_MAX + 8);
+
+    // Flushing returns the cached blocks, and so does thread exit
+    mem_free_inline(again, 16);
+    mem_tcache_flush();
+    my_assert(mem_used() == 0);
+    pthread_t thread;
+    pthread_create(&thread, NULL, cached_worker, NULL);
+    pthread_join(thread, NULL);
+    my_assert(mem_used() == 0);
+
+    // Blocks cached from an old pool are never handed out by a new one
+    mem_free_inline(mem_alloc_inline(8), 8);
+    mem_deinit();
+    mem_init(1024);
+    void *fresh = mem_alloc_inline(8);
+    my_assert(mem_offset(fresh) != MEM_NULL_OFFSET && mem_used() == 8 * MEM_TCACHE_BATCH);
+    mem_free_inline(fresh, 8);
+
+    // Cached blocks go back to the pool before the pressure callbacks run
+    int fired = 0;
+    my_assert(mem_add_pressure_callback(count_pressure, &fired));
+    mem_set_watermark(600);
+    void *base = mem_alloc(512);
+    my_assert(mem_used() == 512 && fired == 0);
+    void *over = mem_alloc(256);
+    my_assert(mem_used() == 768 && fired == 1);
+    mem_free(base);
+    mem_free(over);
+    my_assert(mem_remove_pressure_callback(count_pressure, &fired));
+    mem_set_watermark(0);
+    mem_tcache_flush();
+    my_assert(mem_used() == 0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_interior_pointers()
+{
+    printf_yellow("  Testing frees and resizes of pointers inside a block ---> ");
+    mem_init(1024);
+    char *first = mem_alloc(64);
+    char *second = mem_alloc(64);
+    my_assert(first != NULL && second != NULL && mem_used() == 128);
+
+    // Pointers into a block, even as offsets from another process, are ignored
+    mem_free(first + 8);
+    mem_free(mem_from_offset(mem_offset(second) + 32));
+    my_assert(mem_resize(first + 16, 512) == NULL);
+    my_assert(mem_used() == 128);
+
+    // A block that was merged into its neighbour no longer starts anywhere
+    mem_free(second);
+    mem_free(first);
+    mem_free(second);
+    my_assert(mem_used() == 0);
+    void *whole = mem_alloc(1024);
+    my_assert(whole == first && mem_used() == 1024);
+    mem_free(whole);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef VERSION
@@ -356,6 +960,18 @@ int main(int argc, char *argv[])
         printf(" 14. test_block_merging - Test merging of adjacent free blocks\n");
         printf(" 15. test_non_contiguous_allocation_failure - Ensure failure when no contiguous block fits\n");
         printf(" 16. test_contiguous_allocation_success - Ensure success when a contiguous block fits\n");
+
+        printf("\nShared and Specialized Pools:\n");
+        printf(" 19. test_shared_pool - Test a pool shared between processes\n");
+        printf(" 20. test_snapshot_restore - Test saving and restoring the pool\n");
+        printf(" 21. test_arenas - Test per-thread and per-CPU arenas\n");
+        printf(" 22. test_handles_and_compaction - Test movable blocks and heap compaction\n");
+        printf(" 23. test_huge_allocations - Test large allocations served by mmap\n");
+        printf(" 24. test_calloc - Test zero-initialized allocation and trimming\n");
+        printf(" 25. test_alloc_wait_and_pressure - Test blocking allocation and pressure callbacks\n");
+        printf(" 26. test_size_classes - Test profiled and loaded size classes\n");
+        printf(" 27. test_inline_fast_path - Test thread-cached inline allocation\n");
+        printf(" 28. test_interior_pointers - Test frees and resizes of pointers inside a block\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -392,6 +1008,19 @@ int main(int argc, char *argv[])
         printf("\nVarious other tests:\n");
         test_zero_alloc_and_free();
         test_random_blocks();
+
+        printf("\nTesting Shared and Specialized Pools:\n");
+        test_shared_pool();
+        test_snapshot_restore();
+        test_arenas(MEM_ARENA_PER_THREAD);
+        test_arenas(MEM_ARENA_PER_CPU);
+        test_handles_and_compaction();
+        test_huge_allocations();
+        test_calloc();
+        test_alloc_wait_and_pressure();
+        test_size_classes();
+        test_inline_fast_path();
+        test_interior_pointers();
         break;
     case 1:
         test_init();
@@ -447,6 +1076,37 @@ int main(int argc, char *argv[])
     case 18:
         test_random_blocks();
         break;
+    case 19:
+        test_shared_pool();
+        break;
+    case 20:
+        test_snapshot_restore();
+        break;
+    case 21:
+        test_arenas(MEM_ARENA_PER_THREAD);
+        test_arenas(MEM_ARENA_PER_CPU);
+        break;
+    case 22:
+        test_handles_and_compaction();
+        break;
+    case 23:
+        test_huge_allocations();
+        break;
+    case 24:
+        test_calloc();
+        break;
+    case 25:
+        test_alloc_wait_and_pressure();
+        break;
+    case 26:
+        test_size_classes();
+        break;
+    case 27:
+        test_inline_fast_path();
+        break;
+    case 28:
+        test_interior_pointers();
+        break;
     default:
         printf("Invalid test function\n");
         break;
@@ -0,0 +1,131 @@
+#include "memory_manager.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common_defs.h"
+
+#include "gitdata.h"
+
+void test_pmr_containers()
+{
+    printf_yellow("  Testing pmr containers on the pool ---> ");
+    mem_init(1 << 20);
+    {
+        std::pmr::vector<int> numbers(mm::pool_memory_resource());
+        std::pmr::unordered_map<int, std::pmr::string> names(mm::pool_memory_resource());
+        std::pmr::list<long> values(mm::pool_memory_resource());
+        for (int i = 0; i < 1000; i++)
+        {
+            numbers.push_back(i);
+            names.emplace(i, std::to_string(i) + " is a string long enough to leave the SSO buffer");
+            values.push_front(i);
+        }
+        my_assert(mem_used() > 1000 * (sizeof(int) + sizeof(long)));
+        my_assert(numbers[999] == 999 && names.at(500).compare(0, 3, "500") == 0 && values.front() == 999);
+
+        // Nested containers pick the resource up from their parent
+        my_assert(names.at(1).get_allocator().resource() == mm::pool_memory_resource());
+    }
+    my_assert(mem_used() == 0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+struct alignas(64) CacheLine
+{
+    char bytes[64];
+};
+
+void test_allocator_alignment()
+{
+    printf_yellow("  Testing allocator alignment and exhaustion ---> ");
+    mem_init(64 * 1024);
+    mm::allocator<CacheLine> lines;
+    CacheLine *line = lines.allocate(3);
+    my_assert(((uintptr_t)line & 63) == 0);
+    line[2].bytes[63] = 1;
+    lines.deallocate(line, 3);
+
+    std::pmr::memory_resource *resource = mm::pool_memory_resource();
+    for (size_t alignment = 1; alignment <= 4096; alignment *= 2)
+    {
+        void *ptr = resource->allocate(24, alignment);
+        my_assert(((uintptr_t)ptr & (alignment - 1)) == 0);
+        resource->deallocate(ptr, 24, alignment);
+    }
+    my_assert(mem_used() == 0);
+
+    // Containers with the allocator type, and failure as std::bad_alloc
+    std::vector<double, mm::allocator<double>> doubles(100, 1.5);
+    my_assert(doubles[99] == 1.5);
+    bool thrown = false;
+    try
+    {
+        doubles.resize(1 << 20);
+    }
+    catch (const std::bad_alloc &)
+    {
+        thrown = true;
+    }
+    my_assert(thrown && doubles.size() == 100);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_resource_equality()
+{
+    printf_yellow("  Testing resource and allocator equality ---> ");
+    mm::pool_resource first;
+    mm::pool_resource second;
+    my_assert(first == second);
+    my_assert(first != *std::pmr::new_delete_resource());
+    my_assert(mm::allocator<int>() == mm::allocator<char>());
+    printf_green("[PASS].\n");
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf(" 1. test_pmr_containers - Test pmr containers on the pool\n");
+        printf(" 2. test_allocator_alignment - Test over-aligned allocation and exhaustion\n");
+        printf(" 3. test_resource_equality - Test resource and allocator equality\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case 0:
+        // Running all tests
+        printf("Testing C++ Adapters:\n");
+        test_pmr_containers();
+        test_allocator_alignment();
+        test_resource_equality();
+        break;
+    case 1:
+        test_pmr_containers();
+        break;
+    case 2:
+        test_allocator_alignment();
+        break;
+    case 3:
+        test_resource_equality();
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+    return 0;
+}
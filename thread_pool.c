@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "thread_pool.h"
+
+// Tasks of one thread's share not yet taken, packed as (next << 32) | end so
+// the owner and thieves can both claim tasks with one compare-and-swap. One
+// cache line each so threads taking tasks do not contend.
+typedef struct PoolShare {
+    uint64_t range;
+} __attribute__((aligned(64))) PoolShare;
+
+typedef struct PoolHelper {
+    ThreadPool* pool;
+    int index;
+    pthread_t thread;
+} PoolHelper;
+
+struct ThreadPool {
+    PoolShare shares[THREAD_POOL_MAX];
+    PoolHelper helpers[THREAD_POOL_MAX];   // Entries 1 to threads - 1 are running
+    int threads;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // A batch has started, or the pool is stopping
+    pthread_cond_t idle;        // The last helper has finished the batch
+    unsigned long batch;        // Batches started so far
+    int busy;                   // Helpers still working on the batch
+    bool stop;
+    ThreadPoolTask task;        // Current batch
+    void* ctx;
+    size_t base;                // Number of the batch's first task
+};
+
+static inline uint64_t share_range(uint32_t next, uint32_t end) {
+    return ((uint64_t)next << 32) | end;
+}
+
+// Take the next task of a share
+static bool share_take(PoolShare* share, uint32_t* task) {
+    uint64_t range = __atomic_load_n(&share->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t next = (uint32_t)(range >> 32);
+        uint32_t end = (uint32_t)range;
+        if (next >= end) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&share->range, &range, share_range(next + 1, end), true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *task = next;
+            return true;
+        }
+    }
+}
+
+// Move the back half of another thread's remaining tasks to our own share
+static bool share_steal(ThreadPool* pool, int self) {
+    for (int i = 1; i < pool->threads; i++) {
+        PoolShare* victim = &pool->shares[(self + i) % pool->threads];
+        uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+            uint32_t next = (uint32_t)(range >> 32);
+            uint32_t end = (uint32_t)range;
+            if (next >= end) {
+                break;
+            }
+            uint32_t split = end - (end - next + 1) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &range, share_range(next, split), true,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&pool->shares[self].range, share_range(split, end), __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Run tasks until none are left anywhere
+static void pool_work(ThreadPool* pool, int self) {
+    uint32_t task;
+    do {
+        while (share_take(&pool->shares[self], &task)) {
+            pool->task(pool->base + task, self, pool->ctx);
+        }
+    } while (share_steal(pool, self));
+}
+
+static void* pool_helper(void* arg) {
+    PoolHelper* helper = arg;
+    ThreadPool* pool = helper->pool;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->batch == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+        pool_work(pool, helper->index);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * Start a pool. The thread calling thread_pool_run works as one of the
+ * pool's threads, so threads - 1 helper threads are started.
+ *
+ * @param threads: Threads to run tasks on, at most THREAD_POOL_MAX; 0 or
+ *        less for one per online CPU.
+ * @return The pool, or NULL if it could not be allocated. If helper threads
+ *         fail to start, the pool runs with the ones that did.
+ */
+ThreadPool* thread_pool_create(int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > THREAD_POOL_MAX) {
+        threads = THREAD_POOL_MAX;
+    }
+    ThreadPool* pool = aligned_alloc(64, sizeof(ThreadPool));
+    if (pool == NULL) {
+        printf("Memory allocation for the thread pool failed.\n");
+        return NULL;
+    }
+    memset(pool, 0, sizeof(ThreadPool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    pool->threads = 1;
+    for (int i = 1; i < threads; i++) {
+        pool->helpers[i].pool = pool;
+        pool->helpers[i].index = i;
+        if (pthread_create(&pool->helpers[i].thread, NULL, pool_helper, &pool->helpers[i]) != 0) {
+            printf("Could not start thread %d of the pool; running with %d.\n", i, pool->threads);
+            break;
+        }
+        pool->threads++;
+    }
+    return pool;
+}
+
+// Threads the pool runs tasks on, the calling thread included
+int thread_pool_size(const ThreadPool* pool) {
+    return pool->threads;
+}
+
+/**
+ * Run tasks 0 to tasks - 1 on the pool's threads and wait for all of them.
+ * Tasks may run in any order and at the same time. Only one thread may run
+ * batches on a pool at a time.
+ *
+ * @param pool: Pool to run on.
+ * @param tasks: Number of tasks.
+ * @param task: Function that runs one task.
+ * @param ctx: Passed to task.
+ */
+void thread_pool_run(ThreadPool* pool, size_t tasks, ThreadPoolTask task, void* ctx) {
+    for (size_t base = 0; base < tasks; base += UINT32_MAX) {
+        uint64_t count = tasks - base < UINT32_MAX ? tasks - base : UINT32_MAX;
+        pool->task = task;
+        pool->ctx = ctx;
+        pool->base = base;
+        for (int t = 0; t < pool->threads; t++) {
+            uint32_t begin = (uint32_t)(count * t / pool->threads);
+            uint32_t end = (uint32_t)(count * (t + 1) / pool->threads);
+            __atomic_store_n(&pool->shares[t].range, share_range(begin, end), __ATOMIC_RELAXED);
+        }
+        if (pool->threads > 1) {
+            pthread_mutex_lock(&pool->lock);
+            pool->busy = pool->threads - 1;
+            pool->batch++;
+            pthread_cond_broadcast(&pool->wake);
+            pthread_mutex_unlock(&pool->lock);
+        }
+        pool_work(pool, 0);
+        pthread_mutex_lock(&pool->lock);
+        while (pool->busy > 0) {
+            pthread_cond_wait(&pool->idle, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+// Stop the helper threads and free the pool
+void thread_pool_destroy(ThreadPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->threads; i++) {
+        pthread_join(pool->helpers[i].thread, NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    free(pool);
+}
@@ -0,0 +1,25 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Most threads a pool can have, the calling thread included
+#define THREAD_POOL_MAX 64
+
+// Runs one task of a batch; worker is the index of the thread running it,
+// 0 for the thread that called thread_pool_run
+typedef void (*ThreadPoolTask)(size_t task, int worker, void* ctx);
+
+// Fixed set of worker threads that run batches of numbered tasks. Each
+// thread starts on an equal share of a batch and, once its share is done,
+// steals half of what is left of another thread's share, so uneven tasks
+// still keep every thread busy.
+typedef struct ThreadPool ThreadPool;
+
+ThreadPool* thread_pool_create(int threads);
+int thread_pool_size(const ThreadPool* pool);
+void thread_pool_run(ThreadPool* pool, size_t tasks, ThreadPoolTask task, void* ctx);
+void thread_pool_destroy(ThreadPool* pool);
+
+#endif
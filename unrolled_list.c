@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "memory_manager.h"
+#include "unrolled_list.h"
+#include "list_writer.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ULIST_HAVE_X86 1
+#endif
+
+// Chunks below this fill level borrow from or merge with the next chunk
+#define UNROLLED_MIN_FILL (UNROLLED_CAPACITY / 2)
+
+// Chunk scanners: index of the first match in values[0..count), or -1, and
+// number of matches. Vector versions never read past values[count - 1].
+typedef struct ChunkScanner {
+    int (*find)(const uint16_t* values, int count, uint16_t data);
+    int (*count)(const uint16_t* values, int count, uint16_t data);
+} ChunkScanner;
+
+static int find_scalar(const uint16_t* values, int count, uint16_t data) {
+    for (int i = 0; i < count; i++) {
+        if (values[i] == data) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int count_scalar(const uint16_t* values, int count, uint16_t data) {
+    int matches = 0;
+    for (int i = 0; i < count; i++) {
+        matches += values[i] == data;
+    }
+    return matches;
+}
+
+#ifdef ULIST_HAVE_X86
+// movemask gives two bits per 16-bit lane, hence the halving
+static int find_sse2(const uint16_t* values, int count, uint16_t data) {
+    __m128i needle = _mm_set1_epi16((short)data);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(values + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, needle));
+        if (mask) {
+            return i + __builtin_ctz(mask) / 2;
+        }
+    }
+    int rest = find_scalar(values + i, count - i, data);
+    return rest < 0 ? -1 : i + rest;
+}
+
+static int count_sse2(const uint16_t* values, int count, uint16_t data) {
+    __m128i needle = _mm_set1_epi16((short)data);
+    int matches = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(values + i));
+        matches += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(block, needle))) / 2;
+    }
+    return matches + count_scalar(values + i, count - i, data);
+}
+
+__attribute__((target("avx2")))
+static int find_avx2(const uint16_t* values, int count, uint16_t data) {
+    __m256i needle = _mm256_set1_epi16((short)data);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(values + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, needle));
+        if (mask) {
+            return i + __builtin_ctz(mask) / 2;
+        }
+    }
+    // The tail stays in this function: calling the SSE2 version with the
+    // upper halves of the ymm registers dirty stalls on the transition
+    if (i + 8 <= count) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(values + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(block, _mm256_castsi256_si128(needle)));
+        if (mask) {
+            return i + __builtin_ctz(mask) / 2;
+        }
+        i += 8;
+    }
+    for (; i < count; i++) {
+        if (values[i] == data) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static int count_avx2(const uint16_t* values, int count, uint16_t data) {
+    __m256i needle = _mm256_set1_epi16((short)data);
+    int matches = 0;
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(values + i));
+        matches += __builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, needle))) / 2;
+    }
+    if (i + 8 <= count) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(values + i));
+        matches += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(block, _mm256_castsi256_si128(needle)))) / 2;
+        i += 8;
+    }
+    for (; i < count; i++) {
+        matches += values[i] == data;
+    }
+    return matches;
+}
+#endif
+
+static const ChunkScanner scan_scalar = {find_scalar, count_scalar};
+#ifdef ULIST_HAVE_X86
+static const ChunkScanner scan_sse2 = {find_sse2, count_sse2};
+static const ChunkScanner scan_avx2 = {find_avx2, count_avx2};
+#endif
+
+static const ChunkScanner* scanner = NULL;  // Picked on first use, see ulist_set_simd
+
+static const ChunkScanner* chunk_scanner(void) {
+    const ChunkScanner* current = __atomic_load_n(&scanner, __ATOMIC_RELAXED);
+    if (current == NULL) {
+        ulist_set_simd(ULIST_SIMD_AUTO);
+        current = __atomic_load_n(&scanner, __ATOMIC_RELAXED);
+    }
+    return current;
+}
+
+/**
+ * Selects the instruction set used to search chunks.
+ *
+ * @param level: The instruction set, or ULIST_SIMD_AUTO for the best one the
+ *               CPU supports.
+ *
+ * @return: true if the CPU supports the requested level and it is now used.
+ */
+bool ulist_set_simd(UlistSimd level) {
+    const ChunkScanner* chosen = &scan_scalar;
+#ifdef ULIST_HAVE_X86
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    if (level == ULIST_SIMD_AUTO) {
+        chosen = avx2 ? &scan_avx2 : sse2 ? &scan_sse2 : &scan_scalar;
+    } else if (level == ULIST_SIMD_SSE2 || level == ULIST_SIMD_AVX2) {
+        if (level == ULIST_SIMD_SSE2 ? !sse2 : !avx2) {
+            return false;
+        }
+        chosen = level == ULIST_SIMD_SSE2 ? &scan_sse2 : &scan_avx2;
+    }
+#else
+    if (level == ULIST_SIMD_SSE2 || level == ULIST_SIMD_AVX2) {
+        return false;
+    }
+#endif
+    __atomic_store_n(&scanner, chosen, __ATOMIC_RELAXED);
+    return true;
+}
+
+static UnrolledChunk* chunk_new(UnrolledChunk* next) {
+    UnrolledChunk* chunk = (UnrolledChunk*)mem_alloc_inline(sizeof(UnrolledChunk));
+    if (chunk == NULL) {
+        printf("Memory allocation for new chunk failed.\n");
+        return NULL;
+    }
+    chunk->next = next;
+    chunk->count = 0;
+    return chunk;
+}
+
+// Initialize an empty unrolled list. The memory pool must already be set up.
+void ulist_init(UnrolledList* list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+}
+
+// Append a value, starting a new chunk when the last one is full
+bool ulist_insert(UnrolledList* list, uint16_t data) {
+    UnrolledChunk* tail = list->tail;
+    if (tail == NULL || tail->count == UNROLLED_CAPACITY) {
+        UnrolledChunk* chunk = chunk_new(NULL);
+        if (chunk == NULL) {
+            return false;
+        }
+        if (tail == NULL) {
+            list->head = chunk;
+        } else {
+            tail->next = chunk;
+        }
+        list->tail = tail = chunk;
+    }
+    tail->data[tail->count++] = data;
+    list->length++;
+    return true;
+}
+
+// Insert a value so it ends up at position index (0 to length), splitting a
+// full chunk in two
+bool ulist_insert_at(UnrolledList* list, size_t index, uint16_t data) {
+    if (index > list->length) {
+        printf("Index %zu is out of range.\n", index);
+        return false;
+    }
+    if (index == list->length) {
+        return ulist_insert(list, data);
+    }
+
+    UnrolledChunk* chunk = list->head;
+    while (index > chunk->count || (index == chunk->count && chunk->count == UNROLLED_CAPACITY)) {
+        index -= chunk->count;
+        chunk = chunk->next;
+    }
+
+    if (chunk->count == UNROLLED_CAPACITY) {
+        UnrolledChunk* upper = chunk_new(chunk->next);
+        if (upper == NULL) {
+            return false;
+        }
+        uint16_t keep = UNROLLED_CAPACITY / 2;
+        upper->count = chunk->count - keep;
+        memcpy(upper->data, chunk->data + keep, upper->count * sizeof(uint16_t));
+        chunk->count = keep;
+        chunk->next = upper;
+        if (list->tail == chunk) {
+            list->tail = upper;
+        }
+        if (index > keep) {
+            index -= keep;
+            chunk = upper;
+        }
+    }
+
+    memmove(chunk->data + index + 1, chunk->data + index, (chunk->count - index) * sizeof(uint16_t));
+    chunk->data[index] = data;
+    chunk->count++;
+    list->length++;
+    return true;
+}
+
+// Delete the first occurrence of a value. Underfull chunks borrow from the
+// next chunk, or absorb it when both fit in one.
+bool ulist_delete(UnrolledList* list, uint16_t data) {
+    UnrolledChunk* prev = NULL;
+    const ChunkScanner* scan = chunk_scanner();
+    for (UnrolledChunk* chunk = list->head; chunk != NULL; prev = chunk, chunk = chunk->next) {
+        int i = scan->find(chunk->data, chunk->count, data);
+        if (i < 0) {
+            continue;
+        }
+
+        memmove(chunk->data + i, chunk->data + i + 1, (chunk->count - i - 1) * sizeof(uint16_t));
+        chunk->count--;
+        list->length--;
+
+        UnrolledChunk* next = chunk->next;
+        if (chunk->count == 0) {
+            if (prev == NULL) {
+                list->head = next;
+            } else {
+                prev->next = next;
+            }
+            if (list->tail == chunk) {
+                list->tail = prev;
+            }
+            mem_free_inline(chunk, sizeof(UnrolledChunk));
+        } else if (chunk->count < UNROLLED_MIN_FILL && next != NULL) {
+            if (chunk->count + next->count <= UNROLLED_CAPACITY) {
+                memcpy(chunk->data + chunk->count, next->data, next->count * sizeof(uint16_t));
+                chunk->count += next->count;
+                chunk->next = next->next;
+                if (list->tail == next) {
+                    list->tail = chunk;
+                }
+                mem_free_inline(next, sizeof(UnrolledChunk));
+            } else {
+                uint16_t moved = UNROLLED_MIN_FILL - chunk->count;
+                memcpy(chunk->data + chunk->count, next->data, moved * sizeof(uint16_t));
+                memmove(next->data, next->data + moved, (next->count - moved) * sizeof(uint16_t));
+                chunk->count += moved;
+                next->count -= moved;
+            }
+        }
+        return true;
+    }
+
+    printf("Value %d not found.\n", data);
+    return false;
+}
+
+// Find the position of the first occurrence of a value
+bool ulist_search(const UnrolledList* list, uint16_t data, size_t* index) {
+    const ChunkScanner* scan = chunk_scanner();
+    size_t base = 0;
+    for (const UnrolledChunk* chunk = list->head; chunk != NULL; chunk = chunk->next) {
+        int i = scan->find(chunk->data, chunk->count, data);
+        if (i >= 0) {
+            if (index) {
+                *index = base + i;
+            }
+            return true;
+        }
+        base += chunk->count;
+    }
+    return false;
+}
+
+// Count the occurrences of a value
+size_t ulist_count_value(const UnrolledList* list, uint16_t data) {
+    const ChunkScanner* scan = chunk_scanner();
+    size_t matches = 0;
+    for (const UnrolledChunk* chunk = list->head; chunk != NULL; chunk = chunk->next) {
+        matches += scan->count(chunk->data, chunk->count, data);
+    }
+    return matches;
+}
+
+// Read the value at a position, skipping whole chunks on the way
+bool ulist_get(const UnrolledList* list, size_t index, uint16_t* data) {
+    for (const UnrolledChunk* chunk = list->head; chunk != NULL; chunk = chunk->next) {
+        if (index < chunk->count) {
+            *data = chunk->data[index];
+            return true;
+        }
+        index -= chunk->count;
+    }
+    return false;
+}
+
+// Number of values in O(1)
+size_t ulist_count(const UnrolledList* list) {
+    return list->length;
+}
+
+// Display all values in the same format as list_display
+void ulist_display(const UnrolledList* list) {
+    ListWriter* writer = list_writer_shared();
+    if (writer == NULL) {
+        return;
+    }
+    list_writer_init_file(writer, stdout);
+    list_writer_write(writer, "[", 1);
+    size_t written = 0;
+    for (const UnrolledChunk* chunk = list->head; chunk != NULL; chunk = chunk->next) {
+        for (uint16_t i = 0; i < chunk->count; i++) {
+            if (written++ > 0) {
+                list_writer_write(writer, ", ", 2);
+            }
+            list_writer_u16(writer, chunk->data[i]);
+        }
+    }
+    list_writer_write(writer, "]", 1);
+    list_writer_flush(writer);
+}
+
+// Free all chunks
+void ulist_cleanup(UnrolledList* list) {
+    UnrolledChunk* chunk = list->head;
+    while (chunk != NULL) {
+        UnrolledChunk* next = chunk->next;
+        mem_free_inline(chunk, sizeof(UnrolledChunk));
+        chunk = next;
+    }
+    ulist_init(list);
+}
@@ -0,0 +1,46 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Values per chunk, sized so a chunk fills one 64-byte cache line
+#define UNROLLED_CAPACITY 27
+
+// A chunk of an unrolled list: many values share one next pointer
+typedef struct UnrolledChunk {
+    struct UnrolledChunk* next;         // Pointer to the next chunk
+    uint16_t count;                     // Values in use, at the front of data
+    uint16_t data[UNROLLED_CAPACITY];   // Values in list order
+} UnrolledChunk;
+
+// Unrolled linked list: same operations as the Node list, with a fraction of
+// the cache lines to traverse
+typedef struct UnrolledList {
+    UnrolledChunk* head;    // First chunk, NULL if the list is empty
+    UnrolledChunk* tail;    // Last chunk, NULL if the list is empty
+    size_t length;          // Number of values
+} UnrolledList;
+
+// Instruction set used to scan chunks
+typedef enum {
+    ULIST_SIMD_AUTO,    // Best one the CPU supports (the default)
+    ULIST_SIMD_SCALAR,  // One value at a time
+    ULIST_SIMD_SSE2,    // 8 values per compare
+    ULIST_SIMD_AVX2     // 16 values per compare
+} UlistSimd;
+
+void ulist_init(UnrolledList* list);
+bool ulist_insert(UnrolledList* list, uint16_t data);
+bool ulist_insert_at(UnrolledList* list, size_t index, uint16_t data);
+bool ulist_delete(UnrolledList* list, uint16_t data);
+bool ulist_search(const UnrolledList* list, uint16_t data, size_t* index);
+bool ulist_get(const UnrolledList* list, size_t index, uint16_t* data);
+size_t ulist_count(const UnrolledList* list);
+size_t ulist_count_value(const UnrolledList* list, uint16_t data);
+bool ulist_set_simd(UlistSimd level);
+void ulist_display(const UnrolledList* list);
+void ulist_cleanup(UnrolledList* list);
+
+#endif